@@ -0,0 +1,416 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	AabbTree.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "AabbTree.h"
+#include <Windows.h>
+#include <assert.h>
+
+AabbTree::AabbTree( float margin )
+	:
+	root( nullNode ),
+	freeList( nullNode ),
+	margin( margin )
+{}
+
+int AabbTree::Insert( const RectF& rect )
+{
+	const int leaf = AllocateNode();
+	nodes[leaf].rect = rect;
+	nodes[leaf].box = Fatten( rect );
+	nodes[leaf].height = 0;
+	InsertLeaf( leaf );
+	return leaf;
+}
+
+void AabbTree::Remove( int id )
+{
+	assert( nodes[id].IsLeaf() && nodes[id].height == 0 );
+	RemoveLeaf( id );
+	FreeNode( id );
+}
+
+bool AabbTree::Move( int id,const RectF& rect )
+{
+	assert( nodes[id].IsLeaf() && nodes[id].height == 0 );
+	nodes[id].rect = rect;
+	if( Encloses( nodes[id].box,rect ) )
+	{
+		return false;
+	}
+	RemoveLeaf( id );
+	nodes[id].box = Fatten( rect );
+	InsertLeaf( id );
+	return true;
+}
+
+const RectF& AabbTree::GetRect( int id ) const
+{
+	return nodes[id].rect;
+}
+
+void AabbTree::Query( const RectF& rect,std::vector<int>& out ) const
+{
+	stack.clear();
+	stack.push_back( root );
+	while( !stack.empty() )
+	{
+		const int i = stack.back();
+		stack.pop_back();
+		if( i == nullNode )
+		{
+			continue;
+		}
+		const Node& node = nodes[i];
+		if( !node.box.Overlaps( rect ) )
+		{
+			continue;
+		}
+		if( node.IsLeaf() )
+		{
+			if( node.rect.Overlaps( rect ) )
+			{
+				out.push_back( i );
+			}
+		}
+		else
+		{
+			stack.push_back( node.child1 );
+			stack.push_back( node.child2 );
+		}
+	}
+}
+
+void AabbTree::QueryPoint( Vec2 p,std::vector<int>& out ) const
+{
+	stack.clear();
+	stack.push_back( root );
+	while( !stack.empty() )
+	{
+		const int i = stack.back();
+		stack.pop_back();
+		if( i == nullNode )
+		{
+			continue;
+		}
+		const Node& node = nodes[i];
+		if( !node.box.Contains( p ) )
+		{
+			continue;
+		}
+		if( node.IsLeaf() )
+		{
+			if( node.rect.Contains( p ) )
+			{
+				out.push_back( i );
+			}
+		}
+		else
+		{
+			stack.push_back( node.child1 );
+			stack.push_back( node.child2 );
+		}
+	}
+}
+
+void AabbTree::QueryPairs( std::vector< std::pair<int,int> >& out ) const
+{
+	std::vector<int> hits;
+	for( int i = 0; i < (int)nodes.size(); i++ )
+	{
+		if( nodes[i].height != 0 )
+		{
+			continue;
+		}
+		hits.clear();
+		Query( nodes[i].rect,hits );
+		for( int other : hits )
+		{
+			// each pair is found from both ends, keep the one from the lower id
+			if( other > i )
+			{
+				out.push_back( std::make_pair( i,other ) );
+			}
+		}
+	}
+}
+
+int AabbTree::GetHeight() const
+{
+	return root == nullNode ? 0 : nodes[root].height;
+}
+
+int AabbTree::AllocateNode()
+{
+	int i;
+	if( freeList == nullNode )
+	{
+		i = (int)nodes.size();
+		nodes.push_back( Node() );
+	}
+	else
+	{
+		i = freeList;
+		freeList = nodes[i].parent;
+	}
+	Node& node = nodes[i];
+	node.parent = nullNode;
+	node.child1 = nullNode;
+	node.child2 = nullNode;
+	node.height = 0;
+	return i;
+}
+
+void AabbTree::FreeNode( int i )
+{
+	nodes[i].parent = freeList;
+	nodes[i].height = -1;
+	freeList = i;
+}
+
+void AabbTree::InsertLeaf( int leaf )
+{
+	if( root == nullNode )
+	{
+		root = leaf;
+		nodes[leaf].parent = nullNode;
+		return;
+	}
+
+	// descend towards the sibling that grows the total perimeter least
+	const RectF leafBox = nodes[leaf].box;
+	int index = root;
+	while( !nodes[index].IsLeaf() )
+	{
+		const Node& node = nodes[index];
+		const float perimeter = Perimeter( node.box );
+		const float combinedPerimeter = Perimeter( Union( node.box,leafBox ) );
+		// cost of making a new parent for this node and the leaf
+		const float cost = 2.0f * combinedPerimeter;
+		// minimum cost of pushing the leaf further down
+		const float inheritanceCost = 2.0f * ( combinedPerimeter - perimeter );
+		auto DescendCost = [&]( int child )
+		{
+			const Node& c = nodes[child];
+			const float grown = Perimeter( Union( c.box,leafBox ) );
+			return ( c.IsLeaf() ? grown : grown - Perimeter( c.box ) ) + inheritanceCost;
+		};
+		const float cost1 = DescendCost( node.child1 );
+		const float cost2 = DescendCost( node.child2 );
+		if( cost < cost1 && cost < cost2 )
+		{
+			break;
+		}
+		index = cost1 < cost2 ? node.child1 : node.child2;
+	}
+	const int sibling = index;
+
+	// splice a new parent in above the sibling
+	const int oldParent = nodes[sibling].parent;
+	const int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = Union( leafBox,nodes[sibling].box );
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+	if( oldParent == nullNode )
+	{
+		root = newParent;
+	}
+	else
+	{
+		ReplaceChild( oldParent,sibling,newParent );
+	}
+
+	Refit( nodes[leaf].parent );
+}
+
+void AabbTree::RemoveLeaf( int leaf )
+{
+	if( leaf == root )
+	{
+		root = nullNode;
+		return;
+	}
+
+	// the sibling takes the parent's place
+	const int parent = nodes[leaf].parent;
+	const int grandParent = nodes[parent].parent;
+	const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+	nodes[sibling].parent = grandParent;
+	FreeNode( parent );
+	if( grandParent == nullNode )
+	{
+		root = sibling;
+	}
+	else
+	{
+		ReplaceChild( grandParent,parent,sibling );
+		Refit( grandParent );
+	}
+}
+
+void AabbTree::Refit( int i )
+{
+	while( i != nullNode )
+	{
+		i = Balance( i );
+		Node& node = nodes[i];
+		node.height = 1 + max( nodes[node.child1].height,nodes[node.child2].height );
+		node.box = Union( nodes[node.child1].box,nodes[node.child2].box );
+		i = node.parent;
+	}
+}
+
+// if A's subtrees differ in height by more than one, rotate the taller child up
+// returns the index of the node now at A's position
+int AabbTree::Balance( int iA )
+{
+	Node& A = nodes[iA];
+	if( A.IsLeaf() || A.height < 2 )
+	{
+		return iA;
+	}
+
+	const int iB = A.child1;
+	const int iC = A.child2;
+	Node& B = nodes[iB];
+	Node& C = nodes[iC];
+	const int balance = C.height - B.height;
+
+	if( balance > 1 )
+	{
+		// C goes up, A becomes its first child and keeps the shorter of C's children
+		const int iF = C.child1;
+		const int iG = C.child2;
+		Node& F = nodes[iF];
+		Node& G = nodes[iG];
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+		if( C.parent == nullNode )
+		{
+			root = iC;
+		}
+		else
+		{
+			ReplaceChild( C.parent,iA,iC );
+		}
+		if( F.height > G.height )
+		{
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.box = Union( B.box,G.box );
+			C.box = Union( A.box,F.box );
+			A.height = 1 + max( B.height,G.height );
+			C.height = 1 + max( A.height,F.height );
+		}
+		else
+		{
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.box = Union( B.box,F.box );
+			C.box = Union( A.box,G.box );
+			A.height = 1 + max( B.height,F.height );
+			C.height = 1 + max( A.height,G.height );
+		}
+		return iC;
+	}
+
+	if( balance < -1 )
+	{
+		// B goes up, A becomes its first child and keeps the shorter of B's children
+		const int iD = B.child1;
+		const int iE = B.child2;
+		Node& D = nodes[iD];
+		Node& E = nodes[iE];
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+		if( B.parent == nullNode )
+		{
+			root = iB;
+		}
+		else
+		{
+			ReplaceChild( B.parent,iA,iB );
+		}
+		if( D.height > E.height )
+		{
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.box = Union( C.box,E.box );
+			B.box = Union( A.box,D.box );
+			A.height = 1 + max( C.height,E.height );
+			B.height = 1 + max( A.height,D.height );
+		}
+		else
+		{
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.box = Union( C.box,D.box );
+			B.box = Union( A.box,E.box );
+			A.height = 1 + max( C.height,D.height );
+			B.height = 1 + max( A.height,E.height );
+		}
+		return iB;
+	}
+
+	return iA;
+}
+
+void AabbTree::ReplaceChild( int parent,int oldChild,int newChild )
+{
+	if( nodes[parent].child1 == oldChild )
+	{
+		nodes[parent].child1 = newChild;
+	}
+	else
+	{
+		assert( nodes[parent].child2 == oldChild );
+		nodes[parent].child2 = newChild;
+	}
+}
+
+RectF AabbTree::Fatten( const RectF& rect ) const
+{
+	return RectF( rect.left - margin,rect.right + margin,rect.top - margin,rect.bottom + margin );
+}
+
+RectF AabbTree::Union( const RectF& a,const RectF& b )
+{
+	return RectF( min( a.left,b.left ),max( a.right,b.right ),min( a.top,b.top ),max( a.bottom,b.bottom ) );
+}
+
+float AabbTree::Perimeter( const RectF& r )
+{
+	return 2.0f * ( r.GetWidth() + r.GetHeight() );
+}
+
+bool AabbTree::Encloses( const RectF& outer,const RectF& inner )
+{
+	return inner.left >= outer.left && inner.right <= outer.right &&
+		inner.top >= outer.top && inner.bottom <= outer.bottom;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	AabbTree.h																			  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include "Rect.h"
+#include <vector>
+#include <utility>
+
+// dynamic bounding volume hierarchy (AVL-balanced, perimeter cost insertion)
+// leaves store the object's rect plus a fattened box, so objects that move a little
+// each frame don't restructure the tree; no fixed bounds and no size assumptions
+class AabbTree
+{
+public:
+	// margin is how far the fat box extends past the rect on every side
+	AabbTree( float margin = 4.0f );
+	// returns the id used by Remove / Move / GetRect and reported by the queries
+	int Insert( const RectF& rect );
+	void Remove( int id );
+	// returns true when the rect left its fat box and the leaf was reinserted
+	bool Move( int id,const RectF& rect );
+	const RectF& GetRect( int id ) const;
+	// ids of all objects overlapping rect (same test as _Rect::Overlaps), appended to out
+	void Query( const RectF& rect,std::vector<int>& out ) const;
+	// ids of all objects containing p (same test as _Rect::Contains), appended to out
+	void QueryPoint( Vec2 p,std::vector<int>& out ) const;
+	// every overlapping pair once, lower id first, appended to out
+	void QueryPairs( std::vector< std::pair<int,int> >& out ) const;
+	int GetHeight() const;
+private:
+	struct Node
+	{
+		bool IsLeaf() const
+		{
+			return child1 == nullNode;
+		}
+		// fat box for leaves, union of the children for internal nodes
+		RectF box;
+		// the object's own rect (leaves only)
+		RectF rect;
+		// next free node while on the free list
+		int parent;
+		int child1;
+		int child2;
+		// leaves are 0, free nodes -1
+		int height;
+	};
+	static const int nullNode = -1;
+private:
+	int AllocateNode();
+	void FreeNode( int i );
+	void InsertLeaf( int leaf );
+	void RemoveLeaf( int leaf );
+	// refit boxes and heights from i to the root, rebalancing on the way
+	void Refit( int i );
+	int Balance( int iA );
+	void ReplaceChild( int parent,int oldChild,int newChild );
+	RectF Fatten( const RectF& rect ) const;
+	static RectF Union( const RectF& a,const RectF& b );
+	static float Perimeter( const RectF& r );
+	static bool Encloses( const RectF& outer,const RectF& inner );
+private:
+	std::vector<Node> nodes;
+	int root;
+	int freeList;
+	float margin;
+	mutable std::vector<int> stack;
+};
\ No newline at end of file
@@ -0,0 +1,359 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	ColorLut.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "ColorLut.h"
+#include "Vec2.h"
+#include "Rect.h"
+#include "Surface.h"
+#include "WorkerPool.h"
+#include "Timer.h"
+#include "Profiler.h"
+#include <Windows.h>
+#include <fstream>
+#include <sstream>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+#include <emmintrin.h>
+
+ColorLut::ColorLut( unsigned int size )
+	:
+	size( 0 ),
+	lattice( nullptr ),
+	valid( true )
+{
+	Allocate( size );
+}
+
+ColorLut::ColorLut( const std::wstring& filename )
+	:
+	size( 0 ),
+	lattice( nullptr ),
+	valid( false )
+{
+	valid = LoadCube( filename );
+	if( !valid )
+	{
+		Allocate( 2 );
+	}
+}
+
+ColorLut::~ColorLut()
+{
+	_mm_free( lattice );
+}
+
+bool ColorLut::IsValid() const
+{
+	return valid;
+}
+
+unsigned int ColorLut::GetSize() const
+{
+	return size;
+}
+
+// identity lattice plus the byte -> cell tables for this size and the 0..1 domain
+void ColorLut::Allocate( unsigned int newSize )
+{
+	assert( newSize >= 2 );
+	_mm_free( lattice );
+	size = newSize;
+	lattice = (float*)_mm_malloc( size * size * size * 4 * sizeof( float ),16 );
+	const float step = 1.0f / float( size - 1 );
+	for( unsigned int b = 0; b < size; b++ )
+	{
+		for( unsigned int g = 0; g < size; g++ )
+		{
+			for( unsigned int r = 0; r < size; r++ )
+			{
+				SetEntry( r,g,b,float( r ) * step,float( g ) * step,float( b ) * step );
+			}
+		}
+	}
+	const float domainMin[3] = { 0.0f,0.0f,0.0f };
+	const float domainMax[3] = { 1.0f,1.0f,1.0f };
+	MapInput( domainMin,domainMax );
+	// strides between neighbouring lattice points, in floats
+	const unsigned int dr = 4;
+	const unsigned int dg = size * 4;
+	const unsigned int db = size * size * 4;
+	// middle corners of each tetrahedron indexed by ( r > g ) << 2 | ( g > b ) << 1 | ( r > b );
+	// the path from the near to the far corner steps along the axes in order of fraction
+	const unsigned int corners[8][2] =
+	{
+		{ db,dg + db },			// b >= g >= r
+		{ db,dg + db },			// impossible ( r > b but r <= g <= b )
+		{ dg,dg + db },			// g > b >= r
+		{ dg,dr + dg },			// g >= r > b
+		{ db,dr + db },			// b >= r > g
+		{ dr,dr + db },			// r > b >= g
+		{ dr,dr + dg },			// impossible ( r > g > b but r <= b )
+		{ dr,dr + dg }			// r > g > b
+	};
+	memcpy( tetrahedronCorners,corners,sizeof( corners ) );
+	farCorner = dr + dg + db;
+}
+
+void ColorLut::MapInput( const float domainMin[3],const float domainMax[3] )
+{
+	const unsigned int strides[3] = { 4,size * 4,size * size * 4 };
+	unsigned int* const offsets[3] = { rOffset,gOffset,bOffset };
+	float* const fractions[3] = { rFraction,gFraction,bFraction };
+	for( int axis = 0; axis < 3; axis++ )
+	{
+		const float range = domainMax[axis] - domainMin[axis];
+		for( unsigned int i = 0; i < 256; i++ )
+		{
+			// inputs outside the domain clamp to its edges
+			float t = ( float( i ) / 255.0f - domainMin[axis] ) / range;
+			t = t < 0.0f ? 0.0f : ( t > 1.0f ? 1.0f : t );
+			const float position = t * float( size - 1 );
+			// the top of the domain lands exactly on the last lattice point; keep it in the last cell
+			const unsigned int cell = min( (unsigned int)position,size - 2 );
+			offsets[axis][i] = cell * strides[axis];
+			fractions[axis][i] = position - float( cell );
+		}
+	}
+}
+
+void ColorLut::SetEntry( unsigned int r,unsigned int g,unsigned int b,float red,float green,float blue )
+{
+	assert( r < size && g < size && b < size );
+	float* const entry = &lattice[( ( b * size + g ) * size + r ) * 4];
+	entry[0] = blue * 255.0f;
+	entry[1] = green * 255.0f;
+	entry[2] = red * 255.0f;
+	entry[3] = 0.0f;
+}
+
+bool ColorLut::LoadCube( const std::wstring& filename )
+{
+	std::ifstream file( filename.c_str() );
+	if( !file )
+	{
+		return false;
+	}
+	unsigned int cubeSize = 0;
+	float domainMin[3] = { 0.0f,0.0f,0.0f };
+	float domainMax[3] = { 1.0f,1.0f,1.0f };
+	unsigned int nEntries = 0;
+	std::string line;
+	while( std::getline( file,line ) )
+	{
+		std::istringstream fields( line );
+		std::string keyword;
+		if( !( fields >> keyword ) || keyword[0] == '#' )
+		{
+			continue;
+		}
+		if( keyword == "TITLE" )
+		{
+			continue;
+		}
+		else if( keyword == "LUT_3D_SIZE" )
+		{
+			if( !( fields >> cubeSize ) || cubeSize < 2 || cubeSize > 256 || nEntries != 0 )
+			{
+				return false;
+			}
+			Allocate( cubeSize );
+		}
+		else if( keyword == "LUT_1D_SIZE" )
+		{
+			return false;
+		}
+		else if( keyword == "DOMAIN_MIN" )
+		{
+			fields >> domainMin[0] >> domainMin[1] >> domainMin[2];
+		}
+		else if( keyword == "DOMAIN_MAX" )
+		{
+			fields >> domainMax[0] >> domainMax[1] >> domainMax[2];
+		}
+		else if( keyword == "LUT_3D_INPUT_RANGE" )
+		{
+			// Resolve's form of the domain: one min and max for all three axes
+			fields >> domainMin[0] >> domainMax[0];
+			domainMin[1] = domainMin[2] = domainMin[0];
+			domainMax[1] = domainMax[2] = domainMax[0];
+		}
+		else if( isalpha( (unsigned char)keyword[0] ) )
+		{
+			// keywords this loader doesn't use (LUT_1D_INPUT_RANGE, vendor extensions)
+			continue;
+		}
+		else
+		{
+			// data line: the keyword was the red value
+			std::istringstream values( line );
+			float c[3];
+			if( cubeSize == 0 || nEntries == cubeSize * cubeSize * cubeSize ||
+				!( values >> c[0] >> c[1] >> c[2] ) )
+			{
+				return false;
+			}
+			const unsigned int r = nEntries % cubeSize;
+			const unsigned int g = ( nEntries / cubeSize ) % cubeSize;
+			const unsigned int b = nEntries / ( cubeSize * cubeSize );
+			SetEntry( r,g,b,c[0],c[1],c[2] );
+			nEntries++;
+		}
+	}
+	if( cubeSize == 0 || nEntries != cubeSize * cubeSize * cubeSize )
+	{
+		return false;
+	}
+	// the domain is the range of input values the lattice spans, entries are outputs as is
+	for( int i = 0; i < 3; i++ )
+	{
+		if( !( domainMax[i] > domainMin[i] ) )
+		{
+			return false;
+		}
+	}
+	MapInput( domainMin,domainMax );
+	return true;
+}
+
+namespace
+{
+	// c000 + w0 * ( c1 - c000 ) + w1 * ( c2 - c1 ) + w2 * ( c111 - c2 ), where the
+	// tetrahedron c000 c1 c2 c111 contains the point and w0 >= w1 >= w2
+	inline __m128 Tetrahedron( const float* c000,const float* c1,const float* c2,const float* c111,
+		float w0,float w1,float w2 )
+	{
+		const __m128 v000 = _mm_load_ps( c000 );
+		const __m128 v1 = _mm_load_ps( c1 );
+		const __m128 v2 = _mm_load_ps( c2 );
+		const __m128 v111 = _mm_load_ps( c111 );
+		__m128 rslt = _mm_add_ps( v000,_mm_mul_ps( _mm_set1_ps( w0 ),_mm_sub_ps( v1,v000 ) ) );
+		rslt = _mm_add_ps( rslt,_mm_mul_ps( _mm_set1_ps( w1 ),_mm_sub_ps( v2,v1 ) ) );
+		return _mm_add_ps( rslt,_mm_mul_ps( _mm_set1_ps( w2 ),_mm_sub_ps( v111,v2 ) ) );
+	}
+}
+
+Color ColorLut::Lookup( Color c ) const
+{
+	const float fr = rFraction[c.r];
+	const float fg = gFraction[c.g];
+	const float fb = bFraction[c.b];
+	// which of the six tetrahedra holds the point, from the order of the fractions
+	// (done without branches: the order is close to random on real images)
+	const unsigned int tetrahedron = ( fr > fg ? 4 : 0 ) | ( fg > fb ? 2 : 0 ) | ( fr > fb ? 1 : 0 );
+	const float wMax = fr > fg ? ( fr > fb ? fr : fb ) : ( fg > fb ? fg : fb );
+	const float wMin = fr < fg ? ( fr < fb ? fr : fb ) : ( fg < fb ? fg : fb );
+	const float wMid = fr + fg + fb - wMax - wMin;
+	const float* const p = &lattice[rOffset[c.r] + gOffset[c.g] + bOffset[c.b]];
+	const __m128 rslt = Tetrahedron( p,p + tetrahedronCorners[tetrahedron][0],p + tetrahedronCorners[tetrahedron][1],
+		p + farCorner,wMax,wMid,wMin );
+	// b g r 0 floats -> bytes, source alpha on top
+	const __m128i rslt16 = _mm_packs_epi32( _mm_cvtps_epi32( rslt ),_mm_setzero_si128() );
+	const __m128i packed = _mm_packus_epi16( rslt16,rslt16 );
+	return Color( ( _mm_cvtsi128_si32( packed ) & 0x00FFFFFF ) | ( c & 0xFF000000 ) );
+}
+
+void ColorLut::ApplyRows( Color* buffer,unsigned int pitch,unsigned int width,
+	unsigned int yStart,unsigned int yEnd ) const
+{
+	for( unsigned int y = yStart; y < yEnd; y++ )
+	{
+		Color* const row = &buffer[y * pitch];
+		// neighbouring pixels are often equal (flat fills, upscaled art)
+		Color lastIn = ~row[0];
+		Color lastOut = 0;
+		for( unsigned int x = 0; x < width; x++ )
+		{
+			if( row[x] != lastIn )
+			{
+				lastIn = row[x];
+				lastOut = Lookup( lastIn );
+			}
+			row[x] = lastOut;
+		}
+	}
+}
+
+void ColorLut::Apply( Surface& surface ) const
+{
+	PROFILE_FUNCTION();
+	ApplyRows( surface.GetBuffer(),surface.GetPixelPitch(),surface.GetWidth(),0,surface.GetHeight() );
+}
+
+void ColorLut::Apply( Surface& surface,WorkerPool& pool ) const
+{
+	PROFILE_FUNCTION();
+	// a few bands per thread so an unlucky slow band doesn't stall the join
+	const unsigned int nBands = min( pool.GetThreadCount() * 4,surface.GetHeight() );
+	const unsigned int height = surface.GetHeight();
+	// GetBuffer dirties the opacity tiles, so it is called once here and not by the workers
+	Color* const buffer = surface.GetBuffer();
+	const unsigned int pitch = surface.GetPixelPitch();
+	const unsigned int width = surface.GetWidth();
+	pool.Run( nBands,[&]( unsigned int band )
+	{
+		ApplyRows( buffer,pitch,width,height * band / nBands,height * ( band + 1 ) / nBands );
+	} );
+}
+
+void ColorLut::Benchmark( std::wostream& report )
+{
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	const int nFrames = 10;
+	// smooth gradient with noise in the low bits so the run cache rarely hits
+	Surface frame( width,height );
+	Surface source( width,height );
+	for( unsigned int y = 0; y < height; y++ )
+	{
+		for( unsigned int x = 0; x < width; x++ )
+		{
+			const unsigned int noise = ( x * 7 + y * 13 ) & 7;
+			source.PutPixel( x,y,Color( 255,( x * 255 / width ) ^ noise,( y * 255 / height ) ^ noise,
+				( ( x + y ) & 255 ) ^ noise ) );
+		}
+	}
+
+	report.precision( 3 );
+	report << std::fixed;
+	report << L"Size    Threads    Apply (ms)    ns/pixel" << std::endl;
+	const unsigned int hardwareThreads = max( std::thread::hardware_concurrency(),1u );
+	for( unsigned int size = 17; size <= 65; size = size * 2 - 1 )
+	{
+		ColorLut lut( size );
+		for( unsigned int nThreads = 1; nThreads <= hardwareThreads; nThreads *= 2 )
+		{
+			WorkerPool pool( nThreads - 1 );
+			Timer timer;
+			unsigned long long ticks = 0;
+			for( int i = 0; i < nFrames; i++ )
+			{
+				frame.Copy( source );
+				timer.StartWatch();
+				lut.Apply( frame,pool );
+				timer.StopWatch();
+				ticks += timer.GetTicks();
+			}
+			const double milli = (double)ticks * 1000.0 / (double)timer.GetFrequency() / nFrames;
+			report << size << L"    " << nThreads << L"    " << milli << L"    "
+				<< milli * 1e6 / ( width * height ) << std::endl;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	ColorLut.h																			  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Colors.h"
+#include <string>
+#include <ostream>
+
+class Surface;
+class WorkerPool;
+
+// 3D colour grading table applied as a post-process: every pixel's r,g,b picks a cell of
+// a size^3 lattice and the result is interpolated tetrahedrally from four of its corners
+// (alpha passes through); lattice entries are b g r 0 floats so each corner is one load
+class ColorLut
+{
+public:
+	// identity grade with size entries per axis (17, 33 and 65 are the usual sizes)
+	ColorLut( unsigned int size = 33 );
+	// loads a .cube file (3D only; DOMAIN_MIN / DOMAIN_MAX and LUT_3D_INPUT_RANGE set the
+	// input range, other keywords are skipped); if it can't be parsed IsValid is false and
+	// the lut stays the identity
+	ColorLut( const std::wstring& filename );
+	ColorLut( const ColorLut& ) = delete;
+	ColorLut& operator=( const ColorLut& ) = delete;
+	~ColorLut();
+	bool IsValid() const;
+	unsigned int GetSize() const;
+	// lattice point ( r,g,b ) -> c, channels of c as in a .cube file (0..1)
+	void SetEntry( unsigned int r,unsigned int g,unsigned int b,float red,float green,float blue );
+	Color Lookup( Color c ) const;
+	void Apply( Surface& surface ) const;
+	// same, split into horizontal bands across the pool's threads
+	void Apply( Surface& surface,WorkerPool& pool ) const;
+	// times Apply on a 720p frame for a few lut sizes and thread counts
+	static void Benchmark( std::wostream& report );
+private:
+	void Allocate( unsigned int size );
+	// byte -> cell tables for input values domainMin..domainMax spanning the lattice
+	void MapInput( const float domainMin[3],const float domainMax[3] );
+	bool LoadCube( const std::wstring& filename );
+	void ApplyRows( Color* buffer,unsigned int pitch,unsigned int width,
+		unsigned int yStart,unsigned int yEnd ) const;
+private:
+	unsigned int size;
+	// size^3 entries of 4 floats, r fastest then g then b (.cube order)
+	float* lattice;
+	// per channel byte: offset of the lower lattice point along that axis (in floats) and
+	// the fraction toward the next one
+	unsigned int rOffset[256];
+	unsigned int gOffset[256];
+	unsigned int bOffset[256];
+	float rFraction[256];
+	float gFraction[256];
+	float bFraction[256];
+	// offsets of the two middle corners for each ordering of the fractions, and of the far one
+	unsigned int tetrahedronCorners[8][2];
+	unsigned int farCorner;
+	bool valid;
+};
\ No newline at end of file
@@ -29,8 +29,14 @@ D3DGraphics::D3DGraphics( HWND hWnd )
 pDirect3D( NULL ),
 pDevice( NULL ),
 pBackBuffer( NULL ),
+pExport( nullptr ),
 sysBuffer( screenWidth,screenHeight )
 {
+	if( hWnd == NULL )
+	{
+		return;
+	}
+
 	HRESULT result;
 	
 	pDirect3D = Direct3DCreate9( D3D_SDK_VERSION );
@@ -44,8 +50,10 @@ sysBuffer( screenWidth,screenHeight )
 	d3dpp.Windowed = TRUE;
 	d3dpp.BackBufferFormat = D3DFMT_UNKNOWN;
 
+	// created here on the main thread but driven from Game's render thread in pipelined
+	// mode, so the runtime has to serialize device calls
     result = pDirect3D->CreateDevice( D3DADAPTER_DEFAULT,D3DDEVTYPE_HAL,hWnd,
-		D3DCREATE_HARDWARE_VERTEXPROCESSING | D3DCREATE_PUREDEVICE,&d3dpp,&pDevice );
+		D3DCREATE_HARDWARE_VERTEXPROCESSING | D3DCREATE_PUREDEVICE | D3DCREATE_MULTITHREADED,&d3dpp,&pDevice );
 	assert( !FAILED( result ) );
 
 	result = pDevice->GetBackBuffer( 0,0,D3DBACKBUFFER_TYPE_MONO,&pBackBuffer );
@@ -73,17 +81,47 @@ D3DGraphics::~D3DGraphics()
 
 void D3DGraphics::EndFrame()
 {
+	PROFILE_FUNCTION();
+	if( pDevice == NULL )
+	{
+		// offscreen instances still export, with the slot as the only copy
+		if( pExport )
+		{
+			sysBuffer.Present( pExport->GetPitch(),pExport->BeginFrame() );
+			pExport->EndFrame();
+		}
+		return;
+	}
+
 	HRESULT result;
 	D3DLOCKED_RECT backRect;
 
 	result = pBackBuffer->LockRect( &backRect,NULL,NULL );
 	assert( !FAILED( result ) );
 
-	sysBuffer.Present( backRect.Pitch,(BYTE*)backRect.pBits );
+	if( pExport )
+	{
+		sysBuffer.Present( backRect.Pitch,(BYTE*)backRect.pBits,pExport->GetPitch(),pExport->BeginFrame() );
+		pExport->EndFrame();
+	}
+	else
+	{
+		sysBuffer.Present( backRect.Pitch,(BYTE*)backRect.pBits );
+	}
 
 	result = pBackBuffer->UnlockRect();
 	assert( !FAILED( result ) );
 
-	result = pDevice->Present( NULL,NULL,NULL,NULL );
-	assert( !FAILED( result ) );
+	{
+		PROFILE_ZONE( "IDirect3DDevice9::Present" );
+		result = pDevice->Present( NULL,NULL,NULL,NULL );
+		assert( !FAILED( result ) );
+	}
+}
+
+void D3DGraphics::SetFrameExport( FrameExport* pExport )
+{
+	assert( pExport == nullptr ||
+		( pExport->GetWidth() == screenWidth && pExport->GetHeight() == screenHeight ) );
+	this->pExport = pExport;
 }
\ No newline at end of file
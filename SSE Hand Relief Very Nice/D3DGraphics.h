@@ -26,10 +26,12 @@
 #include "Rect.h"
 #include "Colors.h"
 #include "Surface.h"
+#include "FrameExport.h"
 
 class D3DGraphics
 {
 public:
+	// hWnd == NULL creates an offscreen instance: sysBuffer only, EndFrame presents nothing
 	D3DGraphics( HWND hWnd );
 	~D3DGraphics();
 	inline void BeginFrame()
@@ -37,6 +39,9 @@ public:
 		sysBuffer.Clear();
 	}
 	void EndFrame();
+	// publish every frame from EndFrame on (nullptr stops); the export must match the
+	// screen size and outlive its use here
+	void SetFrameExport( FrameExport* pExport );
 public:
 	static const unsigned int	screenWidth =	1280;
 	static const unsigned int	screenHeight =	720;
@@ -45,6 +50,7 @@ private:
 	IDirect3D9*			pDirect3D;
 	IDirect3DDevice9*	pDevice;
 	IDirect3DSurface9*	pBackBuffer;
+	FrameExport*		pExport;
 public:
 	TextSurface			sysBuffer;
 };
\ No newline at end of file
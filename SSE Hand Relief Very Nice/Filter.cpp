@@ -0,0 +1,773 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	Filter.cpp																			  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "Filter.h"
+#include "Vec2.h"
+#include "Rect.h"
+#include "Surface.h"
+#include "WorkerPool.h"
+#include "Profiler.h"
+#include <Windows.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <emmintrin.h>
+
+namespace Filter
+{
+	namespace
+	{
+		int Gcd( int a,int b )
+		{
+			a = abs( a );
+			b = abs( b );
+			while( b != 0 )
+			{
+				const int t = a % b;
+				a = b;
+				b = t;
+			}
+			return a;
+		}
+	}
+
+	Kernel::Kernel( unsigned int size,const int* weights,int divisor,int bias )
+		:
+		size( size ),
+		divisor( divisor ),
+		bias( bias ),
+		factor( 1 ),
+		separable( false )
+	{
+		assert( size == 3 || size == 5 );
+		assert( divisor != 0 );
+		const int radius = GetRadius();
+		for( unsigned int y = 0; y < size; y++ )
+		{
+			for( unsigned int x = 0; x < size; x++ )
+			{
+				const int w = weights[y * size + x];
+				assert( w >= -32768 && w <= 32767 );
+				if( w != 0 )
+				{
+					const Tap tap = { (int)x - radius,(int)y - radius,(short)w };
+					taps.push_back( tap );
+				}
+			}
+		}
+		Factor( weights );
+	}
+
+	// rank one integer matrices are factor * column * row with primitive integer vectors;
+	// worth it when the two 1D passes have fewer taps than the 2D one
+	void Kernel::Factor( const int* weights )
+	{
+		if( taps.empty() )
+		{
+			return;
+		}
+		const int radius = GetRadius();
+		const int x0 = taps[0].dx + radius;
+		const int y0 = taps[0].dy + radius;
+		const int pivot = weights[y0 * size + x0];
+		for( unsigned int y = 0; y < size; y++ )
+		{
+			for( unsigned int x = 0; x < size; x++ )
+			{
+				if( weights[y * size + x] * pivot != weights[y * size + x0] * weights[y0 * size + x] )
+				{
+					return;
+				}
+			}
+		}
+		int rowGcd = 0;
+		int columnGcd = 0;
+		for( unsigned int i = 0; i < size; i++ )
+		{
+			rowGcd = Gcd( rowGcd,weights[y0 * size + i] );
+			columnGcd = Gcd( columnGcd,weights[i * size + x0] );
+		}
+		for( unsigned int i = 0; i < size; i++ )
+		{
+			const int rowWeight = weights[y0 * size + i] / rowGcd;
+			const int columnWeight = weights[i * size + x0] / columnGcd;
+			if( rowWeight != 0 )
+			{
+				const Tap tap = { (int)i - radius,0,(short)rowWeight };
+				rowTaps.push_back( tap );
+			}
+			if( columnWeight != 0 )
+			{
+				const Tap tap = { 0,(int)i - radius,(short)columnWeight };
+				columnTaps.push_back( tap );
+			}
+		}
+		factor = pivot / ( ( weights[y0 * size + x0] / rowGcd ) * ( weights[y0 * size + x0] / columnGcd ) );
+		separable = rowTaps.size() + columnTaps.size() < taps.size();
+	}
+
+	Kernel Kernel::Sharpen()
+	{
+		const int w[] = { 0,-1,0,-1,5,-1,0,-1,0 };
+		return Kernel( 3,w );
+	}
+
+	Kernel Kernel::Emboss()
+	{
+		const int w[] = { -2,-1,0,-1,1,1,0,1,2 };
+		return Kernel( 3,w );
+	}
+
+	Kernel Kernel::Edge()
+	{
+		const int w[] = { -1,-1,-1,-1,8,-1,-1,-1,-1 };
+		return Kernel( 3,w );
+	}
+
+	Kernel Kernel::Gaussian3()
+	{
+		const int w[] = { 1,2,1,2,4,2,1,2,1 };
+		return Kernel( 3,w,16 );
+	}
+
+	Kernel Kernel::Gaussian5()
+	{
+		const int w[] =
+		{
+			1,4,6,4,1,
+			4,16,24,16,4,
+			6,24,36,24,6,
+			4,16,24,16,4,
+			1,4,6,4,1
+		};
+		return Kernel( 5,w,256 );
+	}
+
+	unsigned int Kernel::GetSize() const
+	{
+		return size;
+	}
+
+	int Kernel::GetRadius() const
+	{
+		return (int)size / 2;
+	}
+
+	bool Kernel::IsSeparable() const
+	{
+		return separable;
+	}
+
+	const std::vector<Kernel::Tap>& Kernel::GetTaps() const
+	{
+		return taps;
+	}
+
+	const std::vector<Kernel::Tap>& Kernel::GetRowTaps() const
+	{
+		return rowTaps;
+	}
+
+	const std::vector<Kernel::Tap>& Kernel::GetColumnTaps() const
+	{
+		return columnTaps;
+	}
+
+	int Kernel::GetSeparableFactor() const
+	{
+		return factor;
+	}
+
+	float Kernel::GetScale() const
+	{
+		return 1.0f / (float)divisor;
+	}
+
+	int Kernel::GetBias() const
+	{
+		return bias;
+	}
+
+	namespace
+	{
+		// 16-byte aligned scratch (std::vector doesn't align __m128i on 32-bit builds)
+		template< class T >
+		class AlignedBuffer
+		{
+		public:
+			AlignedBuffer( size_t count )
+				:
+				p( (T*)_mm_malloc( count * sizeof( T ),16 ) )
+			{}
+			AlignedBuffer( const AlignedBuffer& ) = delete;
+			AlignedBuffer& operator=( const AlignedBuffer& ) = delete;
+			~AlignedBuffer()
+			{
+				_mm_free( p );
+			}
+			T* Get() const
+			{
+				return p;
+			}
+		private:
+			T* p;
+		};
+
+		// runs f( begin,end ) over [0,nItems), in bands across the pool if there is one
+		template< class F >
+		void ForBands( WorkerPool* pPool,unsigned int nItems,F f )
+		{
+			if( pPool == nullptr )
+			{
+				f( 0u,nItems );
+				return;
+			}
+			const unsigned int nBands = min( pPool->GetThreadCount() * 4,nItems );
+			pPool->Run( nBands,[&]( unsigned int band )
+			{
+				f( nItems * band / nBands,nItems * ( band + 1 ) / nBands );
+			} );
+		}
+
+		inline __m128i LoadPixels( const Color* p,unsigned int n )
+		{
+			if( n >= 4 )
+			{
+				return _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+			}
+			unsigned int tmp[4] = { 0,0,0,0 };
+			memcpy( tmp,p,n * sizeof( Color ) );
+			return _mm_loadu_si128( reinterpret_cast<const __m128i*>( tmp ) );
+		}
+
+		inline void StorePixels( Color* p,__m128i v,unsigned int n )
+		{
+			if( n >= 4 )
+			{
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( p ),v );
+				return;
+			}
+			unsigned int tmp[4];
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( tmp ),v );
+			memcpy( p,tmp,n * sizeof( Color ) );
+		}
+
+		////////////////////////////////////
+		// Convolution
+
+		// index into an axis of length n for position i, -1 for Zero outside
+		int ResolveBorder( int i,int n,Border border )
+		{
+			if( i >= 0 && i < n )
+			{
+				return i;
+			}
+			switch( border )
+			{
+			case Clamp:
+				return i < 0 ? 0 : n - 1;
+			case Wrap:
+				return ( i % n + n ) % n;
+			case Mirror:
+			{
+				if( n == 1 )
+				{
+					return 0;
+				}
+				const int period = 2 * ( n - 1 );
+				const int m = ( i % period + period ) % period;
+				return m < n ? m : period - m;
+			}
+			default:
+				return -1;
+			}
+		}
+
+		// rows [yFirst,yFirst + nRows) of src with radius pixels of border on both sides,
+		// wide enough that 4-pixel loads for the last (partial) group stay inside
+		class PaddedRows
+		{
+		public:
+			PaddedRows( const Surface& src,int yFirst,int nRows,int radius,Border border )
+				:
+				stride( ( ( src.GetWidth() + 3 ) & ~3u ) + 2 * radius ),
+				buffer( stride * nRows )
+			{
+				const int width = (int)src.GetWidth();
+				const int height = (int)src.GetHeight();
+				for( int k = 0; k < nRows; k++ )
+				{
+					Color* const row = buffer.Get() + k * stride;
+					const int sy = ResolveBorder( yFirst + k,height,border );
+					if( sy < 0 )
+					{
+						memset( row,0,stride * sizeof( Color ) );
+						continue;
+					}
+					const Color* const pSrc = &src.GetBufferConst()[sy * src.GetPixelPitch()];
+					memcpy( row + radius,pSrc,width * sizeof( Color ) );
+					for( int x = 0; x < (int)stride; x++ )
+					{
+						if( x == radius )
+						{
+							x += width - 1;
+							continue;
+						}
+						const int sx = ResolveBorder( x - radius,width,border );
+						row[x] = sx < 0 ? Color( 0 ) : pSrc[sx];
+					}
+				}
+			}
+			const Color* Row( int k ) const
+			{
+				return buffer.Get() + k * stride;
+			}
+		private:
+			unsigned int stride;
+			AlignedBuffer< Color > buffer;
+		};
+
+		// two taps interleaved for pmaddwd, weights packed as ( b << 16 ) | a
+		struct TapPair
+		{
+			int dxA;
+			int dyA;
+			int dxB;
+			int dyB;
+			int weights;
+		};
+
+		std::vector<TapPair> PairTaps( const std::vector<Kernel::Tap>& taps )
+		{
+			std::vector<TapPair> pairs;
+			for( size_t i = 0; i < taps.size(); i += 2 )
+			{
+				const Kernel::Tap& a = taps[i];
+				// an odd tap out is paired with itself at weight 0
+				const Kernel::Tap& b = i + 1 < taps.size() ? taps[i + 1] : taps[i];
+				const short weightB = i + 1 < taps.size() ? b.weight : 0;
+				const TapPair pair = { a.dx,a.dy,b.dx,b.dy,
+					(int)( (unsigned short)a.weight | ( (unsigned int)(unsigned short)weightB << 16 ) ) };
+				pairs.push_back( pair );
+			}
+			return pairs;
+		}
+
+		// acc[i] += channel sums of pixel i of a * weightA + b * weightB (32-bit lanes)
+		inline void MultiplyAdd( __m128i acc[4],__m128i a,__m128i b,__m128i weights )
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i aLo16 = _mm_unpacklo_epi8( a,zero );
+			const __m128i aHi16 = _mm_unpackhi_epi8( a,zero );
+			const __m128i bLo16 = _mm_unpacklo_epi8( b,zero );
+			const __m128i bHi16 = _mm_unpackhi_epi8( b,zero );
+			acc[0] = _mm_add_epi32( acc[0],_mm_madd_epi16( _mm_unpacklo_epi16( aLo16,bLo16 ),weights ) );
+			acc[1] = _mm_add_epi32( acc[1],_mm_madd_epi16( _mm_unpackhi_epi16( aLo16,bLo16 ),weights ) );
+			acc[2] = _mm_add_epi32( acc[2],_mm_madd_epi16( _mm_unpacklo_epi16( aHi16,bHi16 ),weights ) );
+			acc[3] = _mm_add_epi32( acc[3],_mm_madd_epi16( _mm_unpackhi_epi16( aHi16,bHi16 ),weights ) );
+		}
+
+		// four pixels of pairs applied to rows[ dy ][ x + dx ]
+		inline void Accumulate( __m128i acc[4],const std::vector<TapPair>& pairs,
+			const Color* const* rows,int x )
+		{
+			for( int i = 0; i < 4; i++ )
+			{
+				acc[i] = _mm_setzero_si128();
+			}
+			for( const TapPair& pair : pairs )
+			{
+				MultiplyAdd( acc,
+					_mm_loadu_si128( reinterpret_cast<const __m128i*>( rows[pair.dyA] + x + pair.dxA ) ),
+					_mm_loadu_si128( reinterpret_cast<const __m128i*>( rows[pair.dyB] + x + pair.dxB ) ),
+					_mm_set1_epi32( pair.weights ) );
+			}
+		}
+
+		// exact channel sums of four pixels -> scaled, biased, rounded, clamped colour with
+		// the centre pixels' alpha
+		inline __m128i Finish( const __m128 sums[4],__m128 scale,__m128 bias,__m128i centre )
+		{
+			__m128i rslt32[4];
+			for( int i = 0; i < 4; i++ )
+			{
+				rslt32[i] = _mm_cvtps_epi32( _mm_add_ps( _mm_mul_ps( sums[i],scale ),bias ) );
+			}
+			const __m128i rslt = _mm_packus_epi16(
+				_mm_packs_epi32( rslt32[0],rslt32[1] ),_mm_packs_epi32( rslt32[2],rslt32[3] ) );
+			const __m128i alphaMask = _mm_set1_epi32( 0xFF000000 );
+			return _mm_or_si128( _mm_andnot_si128( alphaMask,rslt ),_mm_and_si128( alphaMask,centre ) );
+		}
+
+		void Convolve2D( const PaddedRows& rows,Color* pDst,unsigned int dstPitch,unsigned int width,
+			const Kernel& kernel,unsigned int yStart,unsigned int yEnd )
+		{
+			const int radius = kernel.GetRadius();
+			// taps address rows / columns relative to the padded origin
+			std::vector<TapPair> pairs = PairTaps( kernel.GetTaps() );
+			for( TapPair& pair : pairs )
+			{
+				pair.dxA += radius;
+				pair.dyA += radius;
+				pair.dxB += radius;
+				pair.dyB += radius;
+			}
+			const __m128 scale = _mm_set1_ps( kernel.GetScale() );
+			const __m128 bias = _mm_set1_ps( (float)kernel.GetBias() );
+			const Color* window[5];
+			for( unsigned int y = yStart; y < yEnd; y++ )
+			{
+				for( int i = 0; i < 2 * radius + 1; i++ )
+				{
+					window[i] = rows.Row( y - yStart + i );
+				}
+				Color* const pRow = &pDst[y * dstPitch];
+				for( unsigned int x = 0; x < width; x += 4 )
+				{
+					__m128i acc[4];
+					Accumulate( acc,pairs,window,x );
+					__m128 sums[4];
+					for( int i = 0; i < 4; i++ )
+					{
+						sums[i] = _mm_cvtepi32_ps( acc[i] );
+					}
+					const __m128i centre = _mm_loadu_si128(
+						reinterpret_cast<const __m128i*>( window[radius] + x + radius ) );
+					StorePixels( pRow + x,Finish( sums,scale,bias,centre ),width - x );
+				}
+			}
+		}
+
+		// horizontal pass into a ring of 2r + 1 float rows, vertical pass out of the ring
+		void ConvolveSeparable( const PaddedRows& rows,Color* pDst,unsigned int dstPitch,unsigned int width,
+			const Kernel& kernel,unsigned int yStart,unsigned int yEnd )
+		{
+			const int radius = kernel.GetRadius();
+			const int ringSize = 2 * radius + 1;
+			const unsigned int ringStride = ( ( width + 3 ) & ~3u ) * 4;
+			AlignedBuffer< float > ring( ringStride * ringSize );
+			std::vector<TapPair> rowPairs = PairTaps( kernel.GetRowTaps() );
+			for( TapPair& pair : rowPairs )
+			{
+				pair.dxA += radius;
+				pair.dxB += radius;
+			}
+			const std::vector<Kernel::Tap>& columnTaps = kernel.GetColumnTaps();
+			const auto Horizontal = [&]( int k )
+			{
+				const Color* const row[1] = { rows.Row( k ) };
+				float* const out = ring.Get() + ( k % ringSize ) * ringStride;
+				for( unsigned int x = 0; x < width; x += 4 )
+				{
+					__m128i acc[4];
+					Accumulate( acc,rowPairs,row,x );
+					for( int i = 0; i < 4; i++ )
+					{
+						_mm_store_ps( out + ( x + i ) * 4,_mm_cvtepi32_ps( acc[i] ) );
+					}
+				}
+			};
+			// factor is applied before the scale so the rounding matches Convolve2D
+			const __m128 factor = _mm_set1_ps( (float)kernel.GetSeparableFactor() );
+			const __m128 scale = _mm_set1_ps( kernel.GetScale() );
+			const __m128 bias = _mm_set1_ps( (float)kernel.GetBias() );
+			for( int k = 0; k < ringSize - 1; k++ )
+			{
+				Horizontal( k );
+			}
+			const unsigned int nColumnTaps = (unsigned int)columnTaps.size();
+			__m128 columnWeights[5];
+			for( unsigned int t = 0; t < nColumnTaps; t++ )
+			{
+				columnWeights[t] = _mm_set1_ps( columnTaps[t].weight );
+			}
+			const float* window[5];
+			for( unsigned int y = yStart; y < yEnd; y++ )
+			{
+				const int k0 = y - yStart;
+				Horizontal( k0 + ringSize - 1 );
+				for( unsigned int t = 0; t < nColumnTaps; t++ )
+				{
+					window[t] = ring.Get() + ( ( k0 + radius + columnTaps[t].dy ) % ringSize ) * ringStride;
+				}
+				Color* const pRow = &pDst[y * dstPitch];
+				const Color* const centreRow = rows.Row( k0 + radius ) + radius;
+				for( unsigned int x = 0; x < width; x += 4 )
+				{
+					__m128 sums[4];
+					for( int i = 0; i < 4; i++ )
+					{
+						__m128 sum = _mm_setzero_ps();
+						for( unsigned int t = 0; t < nColumnTaps; t++ )
+						{
+							sum = _mm_add_ps( sum,_mm_mul_ps( _mm_load_ps( window[t] + ( x + i ) * 4 ),columnWeights[t] ) );
+						}
+						sums[i] = _mm_mul_ps( sum,factor );
+					}
+					const __m128i centre = _mm_loadu_si128( reinterpret_cast<const __m128i*>( centreRow + x ) );
+					StorePixels( pRow + x,Finish( sums,scale,bias,centre ),width - x );
+				}
+			}
+		}
+
+		void Convolve( const Surface& src,Surface& dst,const Kernel& kernel,Border border,WorkerPool* pPool )
+		{
+			assert( &src != &dst );
+			assert( src.GetWidth() == dst.GetWidth() );
+			assert( src.GetHeight() == dst.GetHeight() );
+			const unsigned int width = src.GetWidth();
+			const int radius = kernel.GetRadius();
+			// once, before any bands run
+			Color* const pDst = dst.GetBuffer();
+			const unsigned int dstPitch = dst.GetPixelPitch();
+			ForBands( pPool,src.GetHeight(),[&]( unsigned int yStart,unsigned int yEnd )
+			{
+				const PaddedRows rows( src,(int)yStart - radius,( yEnd - yStart ) + 2 * radius,radius,border );
+				if( kernel.IsSeparable() )
+				{
+					ConvolveSeparable( rows,pDst,dstPitch,width,kernel,yStart,yEnd );
+				}
+				else
+				{
+					Convolve2D( rows,pDst,dstPitch,width,kernel,yStart,yEnd );
+				}
+			} );
+		}
+
+		////////////////////////////////////
+		// Morphology
+
+		struct MaxOp
+		{
+			static __m128i Apply( __m128i a,__m128i b )
+			{
+				return _mm_max_epu8( a,b );
+			}
+			static __m128i Identity()
+			{
+				return _mm_setzero_si128();
+			}
+		};
+
+		struct MinOp
+		{
+			static __m128i Apply( __m128i a,__m128i b )
+			{
+				return _mm_min_epu8( a,b );
+			}
+			static __m128i Identity()
+			{
+				return _mm_set1_epi8( -1 );
+			}
+		};
+
+		// out[i] = op over in[i - r .. i + r], positions outside [0,n) ignored (same as a
+		// clamped border for min / max)
+		// van Herk / Gil-Werman: the padded input is cut into blocks of w = 2r + 1; g holds
+		// prefix and h suffix extremes within each block, and every window is then the op
+		// of one suffix and one prefix, so it's 3 ops per element for any radius
+		template< class Op >
+		void RunningExtreme( const __m128i* in,__m128i* out,unsigned int n,unsigned int r,__m128i* g,__m128i* h )
+		{
+			const unsigned int w = 2 * r + 1;
+			const unsigned int m = n + 2 * r;
+			const __m128i identity = Op::Identity();
+			for( unsigned int i = 0,blockPos = 0; i < m; i++ )
+			{
+				const __m128i v = i < r || i >= n + r ? identity : in[i - r];
+				g[i] = blockPos == 0 ? v : Op::Apply( g[i - 1],v );
+				blockPos = blockPos + 1 == w ? 0 : blockPos + 1;
+			}
+			for( unsigned int i = m; i-- > 0; )
+			{
+				const __m128i v = i < r || i >= n + r ? identity : in[i - r];
+				h[i] = i % w == w - 1 || i == m - 1 ? v : Op::Apply( h[i + 1],v );
+			}
+			for( unsigned int i = 0; i < n; i++ )
+			{
+				out[i] = Op::Apply( h[i],g[i + w - 1] );
+			}
+		}
+
+		inline void Transpose( __m128i& a,__m128i& b,__m128i& c,__m128i& d )
+		{
+			const __m128i ab01 = _mm_unpacklo_epi32( a,b );
+			const __m128i cd01 = _mm_unpacklo_epi32( c,d );
+			const __m128i ab23 = _mm_unpackhi_epi32( a,b );
+			const __m128i cd23 = _mm_unpackhi_epi32( c,d );
+			a = _mm_unpacklo_epi64( ab01,cd01 );
+			b = _mm_unpackhi_epi64( ab01,cd01 );
+			c = _mm_unpacklo_epi64( ab23,cd23 );
+			d = _mm_unpackhi_epi64( ab23,cd23 );
+		}
+
+		// horizontal pass over rows [yStart,yEnd): four rows at a time are transposed so each
+		// vector holds one column of them and the running extreme runs along x
+		template< class Op >
+		void MorphRows( const Color* pSrc,unsigned int srcPitch,Color* pDst,unsigned int dstPitch,
+			unsigned int width,unsigned int radius,unsigned int yStart,unsigned int yEnd )
+		{
+			AlignedBuffer< __m128i > columns( width );
+			AlignedBuffer< __m128i > out( width );
+			AlignedBuffer< __m128i > g( width + 2 * radius );
+			AlignedBuffer< __m128i > h( width + 2 * radius );
+			for( unsigned int y = yStart; y < yEnd; y += 4 )
+			{
+				const unsigned int nRows = min( 4u,yEnd - y );
+				const Color* in[4];
+				Color* rowOut[4];
+				for( unsigned int k = 0; k < 4; k++ )
+				{
+					// short last group repeats its last row (results for it are dropped)
+					const unsigned int row = y + min( k,nRows - 1 );
+					in[k] = &pSrc[row * srcPitch];
+					rowOut[k] = &pDst[row * dstPitch];
+				}
+				unsigned int x = 0;
+				for( ; x + 4 <= width; x += 4 )
+				{
+					__m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>( in[0] + x ) );
+					__m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( in[1] + x ) );
+					__m128i c = _mm_loadu_si128( reinterpret_cast<const __m128i*>( in[2] + x ) );
+					__m128i d = _mm_loadu_si128( reinterpret_cast<const __m128i*>( in[3] + x ) );
+					Transpose( a,b,c,d );
+					columns.Get()[x] = a;
+					columns.Get()[x + 1] = b;
+					columns.Get()[x + 2] = c;
+					columns.Get()[x + 3] = d;
+				}
+				for( ; x < width; x++ )
+				{
+					columns.Get()[x] = _mm_setr_epi32( in[0][x],in[1][x],in[2][x],in[3][x] );
+				}
+				RunningExtreme< Op >( columns.Get(),out.Get(),width,radius,g.Get(),h.Get() );
+				x = 0;
+				for( ; x + 4 <= width; x += 4 )
+				{
+					__m128i a = out.Get()[x];
+					__m128i b = out.Get()[x + 1];
+					__m128i c = out.Get()[x + 2];
+					__m128i d = out.Get()[x + 3];
+					Transpose( a,b,c,d );
+					const __m128i rowsOut[4] = { a,b,c,d };
+					for( unsigned int k = 0; k < nRows; k++ )
+					{
+						_mm_storeu_si128( reinterpret_cast<__m128i*>( rowOut[k] + x ),rowsOut[k] );
+					}
+				}
+				for( ; x < width; x++ )
+				{
+					unsigned int column[4];
+					_mm_storeu_si128( reinterpret_cast<__m128i*>( column ),out.Get()[x] );
+					for( unsigned int k = 0; k < nRows; k++ )
+					{
+						rowOut[k][x] = column[k];
+					}
+				}
+			}
+		}
+
+		// vertical pass over 4-pixel strips [stripStart,stripEnd), rows are already vectors
+		template< class Op >
+		void MorphColumns( const Color* pSrc,unsigned int srcPitch,Color* pDst,unsigned int dstPitch,
+			unsigned int width,unsigned int height,unsigned int radius,unsigned int stripStart,unsigned int stripEnd )
+		{
+			AlignedBuffer< __m128i > column( height );
+			AlignedBuffer< __m128i > out( height );
+			AlignedBuffer< __m128i > g( height + 2 * radius );
+			AlignedBuffer< __m128i > h( height + 2 * radius );
+			for( unsigned int strip = stripStart; strip < stripEnd; strip++ )
+			{
+				const unsigned int x = strip * 4;
+				const unsigned int nPixels = min( 4u,width - x );
+				for( unsigned int y = 0; y < height; y++ )
+				{
+					column.Get()[y] = LoadPixels( &pSrc[y * srcPitch + x],nPixels );
+				}
+				RunningExtreme< Op >( column.Get(),out.Get(),height,radius,g.Get(),h.Get() );
+				for( unsigned int y = 0; y < height; y++ )
+				{
+					StorePixels( &pDst[y * dstPitch + x],out.Get()[y],nPixels );
+				}
+			}
+		}
+
+		template< class Op >
+		void Morph( const Surface& src,Surface& dst,unsigned int radius,WorkerPool* pPool )
+		{
+			assert( &src != &dst );
+			assert( src.GetWidth() == dst.GetWidth() );
+			assert( src.GetHeight() == dst.GetHeight() );
+			const unsigned int width = src.GetWidth();
+			const unsigned int height = src.GetHeight();
+			Surface rows( width,height );
+			const Color* const pSrc = src.GetBufferConst();
+			Color* const pRows = rows.GetBuffer();
+			Color* const pDst = dst.GetBuffer();
+			// square element = row pass then column pass
+			ForBands( pPool,( height + 3 ) / 4,[&]( unsigned int groupStart,unsigned int groupEnd )
+			{
+				MorphRows< Op >( pSrc,src.GetPixelPitch(),pRows,rows.GetPixelPitch(),width,radius,
+					groupStart * 4,min( groupEnd * 4,height ) );
+			} );
+			ForBands( pPool,( width + 3 ) / 4,[&]( unsigned int stripStart,unsigned int stripEnd )
+			{
+				MorphColumns< Op >( pRows,rows.GetPixelPitch(),pDst,dst.GetPixelPitch(),width,height,radius,
+					stripStart,stripEnd );
+			} );
+		}
+	}
+
+	void Convolve( const Surface& src,Surface& dst,const Kernel& kernel,Border border )
+	{
+		PROFILE_FUNCTION();
+		Convolve( src,dst,kernel,border,nullptr );
+	}
+
+	void Convolve( const Surface& src,Surface& dst,const Kernel& kernel,Border border,WorkerPool& pool )
+	{
+		PROFILE_FUNCTION();
+		Convolve( src,dst,kernel,border,&pool );
+	}
+
+	void Dilate( const Surface& src,Surface& dst,unsigned int radius )
+	{
+		PROFILE_FUNCTION();
+		Morph< MaxOp >( src,dst,radius,nullptr );
+	}
+
+	void Dilate( const Surface& src,Surface& dst,unsigned int radius,WorkerPool& pool )
+	{
+		PROFILE_FUNCTION();
+		Morph< MaxOp >( src,dst,radius,&pool );
+	}
+
+	void Erode( const Surface& src,Surface& dst,unsigned int radius )
+	{
+		PROFILE_FUNCTION();
+		Morph< MinOp >( src,dst,radius,nullptr );
+	}
+
+	void Erode( const Surface& src,Surface& dst,unsigned int radius,WorkerPool& pool )
+	{
+		PROFILE_FUNCTION();
+		Morph< MinOp >( src,dst,radius,&pool );
+	}
+}
\ No newline at end of file
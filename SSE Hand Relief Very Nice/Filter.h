@@ -0,0 +1,102 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	Filter.h																			  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include <vector>
+
+class Surface;
+class WorkerPool;
+
+// small convolution kernels and square min / max morphology over whole surfaces
+// every filter reads src and writes dst (which must be a different surface of the same
+// size); the WorkerPool overloads split the work into bands across the pool's threads
+namespace Filter
+{
+	// what the convolution sees past the edges of src
+	enum Border
+	{
+		// repeat the edge pixel
+		Clamp,
+		// continue from the opposite edge
+		Wrap,
+		// reflect about the edge pixel (-1 -> 1)
+		Mirror,
+		// transparent black
+		Zero
+	};
+
+	// size x size integer weights; result = sum( weight * pixel ) / divisor + bias
+	// colour channels are filtered and alpha is copied from the centre pixel
+	// sums are exact integers and scaled once at the end, so the separable path (taken
+	// automatically for rank one kernels like the gaussians) matches the 2D one exactly
+	// weights must fit in 16 bits
+	class Kernel
+	{
+	public:
+		struct Tap
+		{
+			int dx;
+			int dy;
+			short weight;
+		};
+	public:
+		// size 3 or 5, weights row major
+		Kernel( unsigned int size,const int* weights,int divisor = 1,int bias = 0 );
+		static Kernel Sharpen();
+		static Kernel Emboss();
+		static Kernel Edge();
+		static Kernel Gaussian3();
+		static Kernel Gaussian5();
+		unsigned int GetSize() const;
+		int GetRadius() const;
+		bool IsSeparable() const;
+		// non-zero taps of the full kernel
+		const std::vector<Tap>& GetTaps() const;
+		// factors when separable: weight( x,y ) == factor * row[x] * column[y]
+		const std::vector<Tap>& GetRowTaps() const;
+		const std::vector<Tap>& GetColumnTaps() const;
+		int GetSeparableFactor() const;
+		// what the integer sum gets multiplied by before the bias is added
+		float GetScale() const;
+		int GetBias() const;
+	private:
+		void Factor( const int* weights );
+	private:
+		unsigned int size;
+		std::vector<Tap> taps;
+		std::vector<Tap> rowTaps;
+		std::vector<Tap> columnTaps;
+		int divisor;
+		int bias;
+		int factor;
+		bool separable;
+	};
+
+	void Convolve( const Surface& src,Surface& dst,const Kernel& kernel,Border border = Clamp );
+	void Convolve( const Surface& src,Surface& dst,const Kernel& kernel,Border border,WorkerPool& pool );
+	// per-channel max / min over the ( 2 * radius + 1 )^2 square around each pixel
+	// (alpha included, so dilating a sprite's alpha grows its outline); running extremes
+	// after van Herk / Gil-Werman, so the cost doesn't depend on the radius
+	void Dilate( const Surface& src,Surface& dst,unsigned int radius );
+	void Dilate( const Surface& src,Surface& dst,unsigned int radius,WorkerPool& pool );
+	void Erode( const Surface& src,Surface& dst,unsigned int radius );
+	void Erode( const Surface& src,Surface& dst,unsigned int radius,WorkerPool& pool );
+}
\ No newline at end of file
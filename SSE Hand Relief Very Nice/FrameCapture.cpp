@@ -0,0 +1,521 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	FrameCapture.cpp																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "FrameCapture.h"
+#include <Windows.h>
+#include <string.h>
+#include <assert.h>
+
+namespace
+{
+	unsigned char* PutBigEndian( unsigned char* p,unsigned int value )
+	{
+		p[0] = (unsigned char)( value >> 24 );
+		p[1] = (unsigned char)( value >> 16 );
+		p[2] = (unsigned char)( value >> 8 );
+		p[3] = (unsigned char)value;
+		return p + 4;
+	}
+
+	unsigned int GetBigEndian( const unsigned char* p )
+	{
+		return (unsigned int)p[0] << 24 | (unsigned int)p[1] << 16 | (unsigned int)p[2] << 8 | p[3];
+	}
+
+	const unsigned char qoiEndMarker[8] = { 0,0,0,0,0,0,0,1 };
+}
+
+FrameCapture::FrameCapture( unsigned int nEncoders,unsigned int nBuffers )
+	:
+	freeBuffers( nBuffers ),
+	nInFlight( 0 ),
+	nDropped( 0 ),
+	stopping( false ),
+	sequenceFormat( Raw ),
+	sequenceFrameRate( 60 ),
+	sequenceActive( false ),
+	nextTicket( 0 ),
+	nextToWrite( 0 ),
+	yuvMatrix( Yuv::BT601 )
+{
+	assert( nEncoders > 0 );
+	assert( nBuffers > 0 );
+	for( unsigned int i = 0; i < nEncoders; i++ )
+	{
+		encoders.push_back( std::thread( &FrameCapture::EncoderLoop,this ) );
+	}
+}
+
+FrameCapture::~FrameCapture()
+{
+	if( IsSequenceActive() )
+	{
+		EndSequence();
+	}
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		stopping = true;
+	}
+	queued.notify_all();
+	for( std::thread& encoder : encoders )
+	{
+		encoder.join();
+	}
+}
+
+bool FrameCapture::Screenshot( const Surface& frame,const std::wstring& filename,Format format )
+{
+	PROFILE_FUNCTION();
+	Job job;
+	job.format = format;
+	job.matrix = yuvMatrix;
+	job.frameRate = 60;
+	job.filename = filename;
+	job.inSequence = false;
+	job.ticket = 0;
+	return Submit( frame,job );
+}
+
+bool FrameCapture::BeginSequence( const std::wstring& filename,Format format,unsigned int frameRate )
+{
+	assert( !IsSequenceActive() );
+	std::lock_guard<std::mutex> lock( sequenceMutex );
+	sequenceFile.open( filename.c_str(),std::ios::binary );
+	if( !sequenceFile )
+	{
+		return false;
+	}
+	sequenceFormat = format;
+	sequenceFrameRate = frameRate;
+	sequenceActive = true;
+	nextToWrite = 0;
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		nextTicket = 0;
+	}
+	return true;
+}
+
+bool FrameCapture::IsSequenceActive() const
+{
+	std::lock_guard<std::mutex> lock( sequenceMutex );
+	return sequenceActive;
+}
+
+bool FrameCapture::CaptureFrame( const Surface& frame )
+{
+	PROFILE_FUNCTION();
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock( sequenceMutex );
+		if( !sequenceActive )
+		{
+			return false;
+		}
+		job.format = sequenceFormat;
+		job.frameRate = sequenceFrameRate;
+	}
+	job.matrix = yuvMatrix;
+	job.inSequence = true;
+	return Submit( frame,job );
+}
+
+void FrameCapture::EndSequence()
+{
+	PROFILE_FUNCTION();
+	unsigned long long nFrames;
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		nFrames = nextTicket;
+	}
+	std::unique_lock<std::mutex> lock( sequenceMutex );
+	sequenceAdvanced.wait( lock,[this,nFrames](){ return nextToWrite == nFrames; } );
+	sequenceFile.close();
+	sequenceActive = false;
+}
+
+void FrameCapture::Flush()
+{
+	PROFILE_FUNCTION();
+	std::unique_lock<std::mutex> lock( mutex );
+	finished.wait( lock,[this](){ return nInFlight == 0; } );
+}
+
+unsigned int FrameCapture::GetDroppedCount() const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	return nDropped;
+}
+
+void FrameCapture::SetYuvMatrix( Yuv::Matrix matrix )
+{
+	yuvMatrix = matrix;
+}
+
+bool FrameCapture::Submit( const Surface& frame,Job& job )
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		if( freeBuffers.empty() )
+		{
+			nDropped++;
+			return false;
+		}
+		job.pixels = std::move( freeBuffers.back() );
+		freeBuffers.pop_back();
+		nInFlight++;
+		if( job.inSequence )
+		{
+			job.ticket = nextTicket++;
+		}
+	}
+	// the only per-frame cost on the calling thread, and no allocation once the
+	// buffers have grown to the frame size
+	job.width = frame.GetWidth();
+	job.height = frame.GetHeight();
+	job.pixels.resize( job.width * job.height );
+	const Color* const pSrc = frame.GetBufferConst();
+	for( unsigned int y = 0; y < job.height; y++ )
+	{
+		memcpy( &job.pixels[y * job.width],&pSrc[y * frame.GetPixelPitch()],job.width * sizeof( Color ) );
+	}
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		jobs.push_back( std::move( job ) );
+	}
+	queued.notify_one();
+	return true;
+}
+
+void FrameCapture::EncoderLoop()
+{
+	std::vector<unsigned char> data;
+	while( true )
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			queued.wait( lock,[this](){ return stopping || !jobs.empty(); } );
+			if( jobs.empty() )
+			{
+				return;
+			}
+			job = std::move( jobs.front() );
+			jobs.pop_front();
+		}
+		data.clear();
+		Encode( job,data );
+		if( job.inSequence )
+		{
+			WriteSequenceFrame( job,data );
+		}
+		else
+		{
+			std::ofstream file( job.filename.c_str(),std::ios::binary );
+			WriteHeader( file,job );
+			file.write( reinterpret_cast<const char*>( data.data() ),data.size() );
+		}
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			freeBuffers.push_back( std::move( job.pixels ) );
+			nInFlight--;
+		}
+		finished.notify_all();
+	}
+}
+
+void FrameCapture::Encode( const Job& job,std::vector<unsigned char>& out ) const
+{
+	PROFILE_FUNCTION();
+	switch( job.format )
+	{
+	case Qoi:
+		EncodeQoi( job.pixels.data(),job.width,job.height,job.width,out );
+		break;
+	case Raw:
+		out.resize( job.pixels.size() * sizeof( Color ) );
+		memcpy( out.data(),job.pixels.data(),out.size() );
+		break;
+	case Y4m:
+	{
+		static const char marker[] = "FRAME\n";
+		const unsigned int markerSize = sizeof( marker ) - 1;
+		const unsigned int chromaWidth = ( job.width + 1 ) / 2;
+		const unsigned int chromaHeight = ( job.height + 1 ) / 2;
+		const unsigned int lumaSize = job.width * job.height;
+		const unsigned int chromaSize = chromaWidth * chromaHeight;
+		out.resize( markerSize + lumaSize + chromaSize * 2 );
+		memcpy( out.data(),marker,markerSize );
+		unsigned char* const pY = out.data() + markerSize;
+		Yuv::Convert< Pixel::SSE2 >( job.pixels.data(),job.width,job.height,job.width,
+			Yuv::I420( pY,job.width,pY + lumaSize,pY + lumaSize + chromaSize,chromaWidth ),job.matrix );
+		break;
+	}
+	}
+}
+
+// stream header, nothing for QOI (every image has its own)
+void FrameCapture::WriteHeader( std::ofstream& file,const Job& job )
+{
+	switch( job.format )
+	{
+	case Raw:
+		file.write( "CHRW",4 );
+		file.write( reinterpret_cast<const char*>( &job.width ),sizeof( job.width ) );
+		file.write( reinterpret_cast<const char*>( &job.height ),sizeof( job.height ) );
+		break;
+	case Y4m:
+	{
+		file << "YUV4MPEG2 W" << job.width << " H" << job.height << " F" << job.frameRate
+			<< ":1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void FrameCapture::WriteSequenceFrame( const Job& job,const std::vector<unsigned char>& data )
+{
+	// frames encode out of order across the encoders but go into the file in order;
+	// earlier tickets were dequeued first, so whoever holds them is already encoding
+	std::unique_lock<std::mutex> lock( sequenceMutex );
+	sequenceAdvanced.wait( lock,[this,&job](){ return nextToWrite == job.ticket; } );
+	// sequences share one header, so every frame must match the first one's size
+	if( job.ticket == 0 )
+	{
+		WriteHeader( sequenceFile,job );
+	}
+	sequenceFile.write( reinterpret_cast<const char*>( data.data() ),data.size() );
+	nextToWrite++;
+	lock.unlock();
+	sequenceAdvanced.notify_all();
+}
+
+// reference format: https://qoiformat.org/qoi-specification.pdf
+void FrameCapture::EncodeQoi( const Color* pixels,unsigned int width,unsigned int height,
+	unsigned int pixelPitch,std::vector<unsigned char>& out )
+{
+	enum : unsigned char
+	{
+		OpIndex = 0x00,
+		OpDiff = 0x40,
+		OpLuma = 0x80,
+		OpRun = 0xC0,
+		OpRgb = 0xFE,
+		OpRgba = 0xFF
+	};
+	const size_t start = out.size();
+	// header, worst case of 5 bytes per pixel, end marker
+	out.resize( start + 14 + (size_t)width * height * 5 + 8 );
+	unsigned char* const pBegin = &out[start];
+	unsigned char* p = pBegin;
+	*p++ = 'q';
+	*p++ = 'o';
+	*p++ = 'i';
+	*p++ = 'f';
+	p = PutBigEndian( p,width );
+	p = PutBigEndian( p,height );
+	// 4 channels, sRGB with linear alpha
+	*p++ = 4;
+	*p++ = 0;
+
+	unsigned int index[64];
+	memset( index,0,sizeof( index ) );
+	// opaque black
+	unsigned int prev = 0xFF000000;
+	unsigned int run = 0;
+	for( unsigned int y = 0; y < height; y++ )
+	{
+		const unsigned int* const row = reinterpret_cast<const unsigned int*>( &pixels[y * pixelPitch] );
+		for( unsigned int x = 0; x < width; x++ )
+		{
+			const unsigned int px = row[x];
+			if( px == prev )
+			{
+				if( ++run == 62 )
+				{
+					*p++ = (unsigned char)( OpRun | ( run - 1 ) );
+					run = 0;
+				}
+				continue;
+			}
+			if( run > 0 )
+			{
+				*p++ = (unsigned char)( OpRun | ( run - 1 ) );
+				run = 0;
+			}
+			const int r = ( px >> 16 ) & 0xFF;
+			const int g = ( px >> 8 ) & 0xFF;
+			const int b = px & 0xFF;
+			const int a = px >> 24;
+			const unsigned int hash = ( r * 3 + g * 5 + b * 7 + a * 11 ) & 63;
+			if( index[hash] == px )
+			{
+				*p++ = (unsigned char)( OpIndex | hash );
+			}
+			else
+			{
+				index[hash] = px;
+				if( ( ( px ^ prev ) & 0xFF000000 ) == 0 )
+				{
+					// channel differences wrap around like the decoder's byte arithmetic
+					const int dr = (signed char)( r - (int)( ( prev >> 16 ) & 0xFF ) );
+					const int dg = (signed char)( g - (int)( ( prev >> 8 ) & 0xFF ) );
+					const int db = (signed char)( b - (int)( prev & 0xFF ) );
+					const int drg = dr - dg;
+					const int dbg = db - dg;
+					if( dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1 )
+					{
+						*p++ = (unsigned char)( OpDiff | ( dr + 2 ) << 4 | ( dg + 2 ) << 2 | ( db + 2 ) );
+					}
+					else if( dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7 )
+					{
+						*p++ = (unsigned char)( OpLuma | ( dg + 32 ) );
+						*p++ = (unsigned char)( ( drg + 8 ) << 4 | ( dbg + 8 ) );
+					}
+					else
+					{
+						*p++ = OpRgb;
+						*p++ = (unsigned char)r;
+						*p++ = (unsigned char)g;
+						*p++ = (unsigned char)b;
+					}
+				}
+				else
+				{
+					*p++ = OpRgba;
+					*p++ = (unsigned char)r;
+					*p++ = (unsigned char)g;
+					*p++ = (unsigned char)b;
+					*p++ = (unsigned char)a;
+				}
+			}
+			prev = px;
+		}
+	}
+	if( run > 0 )
+	{
+		*p++ = (unsigned char)( OpRun | ( run - 1 ) );
+	}
+	memcpy( p,qoiEndMarker,sizeof( qoiEndMarker ) );
+	p += sizeof( qoiEndMarker );
+	out.resize( start + ( p - pBegin ) );
+}
+
+size_t FrameCapture::DecodeQoi( const unsigned char* data,size_t size,Color* pixels,
+	unsigned int width,unsigned int height,unsigned int pixelPitch )
+{
+	const size_t headerSize = 14;
+	if( size < headerSize + sizeof( qoiEndMarker ) || memcmp( data,"qoif",4 ) != 0 ||
+		GetBigEndian( data + 4 ) != width || GetBigEndian( data + 8 ) != height )
+	{
+		return 0;
+	}
+	const unsigned char* p = data + headerSize;
+	// ops never straddle the end marker, so checking for one byte of op here and the
+	// payload bytes below keeps every read in range
+	const unsigned char* const end = data + size - sizeof( qoiEndMarker );
+	unsigned int index[64];
+	memset( index,0,sizeof( index ) );
+	unsigned int px = 0xFF000000;
+	unsigned int run = 0;
+	for( unsigned int y = 0; y < height; y++ )
+	{
+		unsigned int* const row = reinterpret_cast<unsigned int*>( &pixels[y * pixelPitch] );
+		for( unsigned int x = 0; x < width; x++ )
+		{
+			if( run > 0 )
+			{
+				run--;
+				row[x] = px;
+				continue;
+			}
+			if( p >= end )
+			{
+				return 0;
+			}
+			const unsigned int op = *p++;
+			int r = ( px >> 16 ) & 0xFF;
+			int g = ( px >> 8 ) & 0xFF;
+			int b = px & 0xFF;
+			int a = px >> 24;
+			if( op == 0xFE || op == 0xFF )
+			{
+				const unsigned int nBytes = op == 0xFE ? 3 : 4;
+				if( end - p < (ptrdiff_t)nBytes )
+				{
+					return 0;
+				}
+				r = p[0];
+				g = p[1];
+				b = p[2];
+				if( op == 0xFF )
+				{
+					a = p[3];
+				}
+				p += nBytes;
+			}
+			else
+			{
+				switch( op & 0xC0 )
+				{
+				case 0x00:
+					px = index[op];
+					row[x] = px;
+					continue;
+				case 0x40:
+					r += ( ( op >> 4 ) & 3 ) - 2;
+					g += ( ( op >> 2 ) & 3 ) - 2;
+					b += ( op & 3 ) - 2;
+					break;
+				case 0x80:
+				{
+					if( p >= end )
+					{
+						return 0;
+					}
+					const int dg = (int)( op & 0x3F ) - 32;
+					const unsigned int drdb = *p++;
+					r += dg - 8 + (int)( drdb >> 4 );
+					g += dg;
+					b += dg - 8 + (int)( drdb & 0x0F );
+					break;
+				}
+				default:
+					// this pixel plus ( op & 0x3F ) more
+					run = op & 0x3F;
+					row[x] = px;
+					index[( r * 3 + g * 5 + b * 7 + a * 11 ) & 63] = px;
+					continue;
+				}
+			}
+			px = (unsigned int)( a & 0xFF ) << 24 | (unsigned int)( r & 0xFF ) << 16 |
+				(unsigned int)( g & 0xFF ) << 8 | (unsigned int)( b & 0xFF );
+			index[( ( r & 0xFF ) * 3 + ( g & 0xFF ) * 5 + ( b & 0xFF ) * 7 + ( a & 0xFF ) * 11 ) & 63] = px;
+			row[x] = px;
+		}
+	}
+	if( memcmp( p,qoiEndMarker,sizeof( qoiEndMarker ) ) != 0 )
+	{
+		return 0;
+	}
+	return p + sizeof( qoiEndMarker ) - data;
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	FrameCapture.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Yuv.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// screenshots and frame sequences written off the frame thread
+// the calling thread only copies the frame into a pooled buffer; encoder threads take
+// frames in parallel, and sequence frames are appended to their file in capture order
+// when every buffer is in flight the frame is dropped rather than stalling the caller
+class FrameCapture
+{
+public:
+	enum Format
+	{
+		// QOI ("Quite OK Image"), lossless, alpha kept
+		Qoi,
+		// 'C' 'H' 'R' 'W', uint32 width, uint32 height, then width * height BGRA pixels
+		// per frame (a sequence is one header followed by every frame)
+		Raw,
+		// YUV4MPEG2 4:2:0, studio range, converted on the encoder threads; the matrix
+		// (SetYuvMatrix) can't be signalled in the stream, so tell the consumer if it's BT.709
+		// a sequence written to a named pipe feeds an external encoder directly
+		Y4m
+	};
+public:
+	FrameCapture( unsigned int nEncoders = 2,unsigned int nBuffers = 4 );
+	FrameCapture( const FrameCapture& ) = delete;
+	FrameCapture& operator=( const FrameCapture& ) = delete;
+	// finishes everything already captured
+	~FrameCapture();
+	// false if the frame was dropped
+	bool Screenshot( const Surface& frame,const std::wstring& filename,Format format = Qoi );
+	// QOI sequences are the frames' QOI images back to back
+	bool BeginSequence( const std::wstring& filename,Format format = Raw,unsigned int frameRate = 60 );
+	bool IsSequenceActive() const;
+	// false if the frame was dropped (or no sequence is active)
+	bool CaptureFrame( const Surface& frame );
+	// blocks until every frame of the sequence is in the file
+	void EndSequence();
+	// blocks until every captured frame is written
+	void Flush();
+	unsigned int GetDroppedCount() const;
+	// for Y4m frames captured from now on
+	void SetYuvMatrix( Yuv::Matrix matrix );
+	// appends the QOI encoding of a width x height image to out
+	static void EncodeQoi( const Color* pixels,unsigned int width,unsigned int height,
+		unsigned int pixelPitch,std::vector<unsigned char>& out );
+	// decodes a QOI image of exactly width x height, returns the bytes it used or 0 if
+	// the data is malformed, truncated or a different size
+	static size_t DecodeQoi( const unsigned char* data,size_t size,Color* pixels,
+		unsigned int width,unsigned int height,unsigned int pixelPitch );
+private:
+	struct Job
+	{
+		std::vector<Color> pixels;
+		unsigned int width;
+		unsigned int height;
+		Format format;
+		Yuv::Matrix matrix;
+		unsigned int frameRate;
+		// screenshots only
+		std::wstring filename;
+		// sequence frames only, position in the sequence file
+		bool inSequence;
+		unsigned long long ticket;
+	};
+private:
+	bool Submit( const Surface& frame,Job& job );
+	void EncoderLoop();
+	void Encode( const Job& job,std::vector<unsigned char>& out ) const;
+	void WriteSequenceFrame( const Job& job,const std::vector<unsigned char>& data );
+	static void WriteHeader( std::ofstream& file,const Job& job );
+private:
+	// queue and buffer pool
+	mutable std::mutex mutex;
+	std::condition_variable queued;
+	std::condition_variable finished;
+	std::deque<Job> jobs;
+	std::vector<std::vector<Color>> freeBuffers;
+	unsigned int nInFlight;
+	unsigned int nDropped;
+	bool stopping;
+	// sequence output, frames are written in ticket order
+	mutable std::mutex sequenceMutex;
+	std::condition_variable sequenceAdvanced;
+	std::ofstream sequenceFile;
+	Format sequenceFormat;
+	unsigned int sequenceFrameRate;
+	bool sequenceActive;
+	unsigned long long nextTicket;
+	unsigned long long nextToWrite;
+	// caller thread only
+	Yuv::Matrix yuvMatrix;
+	std::vector<std::thread> encoders;
+};
\ No newline at end of file
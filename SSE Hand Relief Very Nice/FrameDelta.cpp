@@ -0,0 +1,296 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	FrameDelta.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "FrameDelta.h"
+#include "FrameCapture.h"
+#include <Windows.h>
+#include <string.h>
+#include <assert.h>
+#include <emmintrin.h>
+
+namespace FrameDelta
+{
+	namespace
+	{
+		const size_t headerSize = 24;
+		// largest frame side the decoder accepts (the D3D9 texture limit on current hardware)
+		const unsigned int maxDimension = 16384;
+
+		void Put32( std::vector<unsigned char>& out,size_t pos,unsigned int value )
+		{
+			memcpy( &out[pos],&value,sizeof( value ) );
+		}
+
+		void Append32( std::vector<unsigned char>& out,unsigned int value )
+		{
+			out.resize( out.size() + sizeof( value ) );
+			Put32( out,out.size() - sizeof( value ),value );
+		}
+
+		unsigned int Get32( const unsigned char* p )
+		{
+			unsigned int value;
+			memcpy( &value,p,sizeof( value ) );
+			return value;
+		}
+
+		// stops at the first differing row, and a full-width row costs four compares and
+		// one movemask
+		bool TileChanged( const Color* pCur,unsigned int curPitch,const Color* pRef,unsigned int refPitch,
+			unsigned int width,unsigned int height )
+		{
+			for( unsigned int y = 0; y < height; y++,pCur += curPitch,pRef += refPitch )
+			{
+				const __m128i* const cur = reinterpret_cast<const __m128i*>( pCur );
+				const __m128i* const ref = reinterpret_cast<const __m128i*>( pRef );
+				if( width == tileSize )
+				{
+					const __m128i equal = _mm_and_si128(
+						_mm_and_si128(
+							_mm_cmpeq_epi32( _mm_loadu_si128( cur ),_mm_loadu_si128( ref ) ),
+							_mm_cmpeq_epi32( _mm_loadu_si128( cur + 1 ),_mm_loadu_si128( ref + 1 ) ) ),
+						_mm_and_si128(
+							_mm_cmpeq_epi32( _mm_loadu_si128( cur + 2 ),_mm_loadu_si128( ref + 2 ) ),
+							_mm_cmpeq_epi32( _mm_loadu_si128( cur + 3 ),_mm_loadu_si128( ref + 3 ) ) ) );
+					if( _mm_movemask_epi8( equal ) != 0xFFFF )
+					{
+						return true;
+					}
+				}
+				else
+				{
+					unsigned int x = 0;
+					for( ; x + 4 <= width; x += 4 )
+					{
+						const __m128i equal = _mm_cmpeq_epi32( _mm_loadu_si128( cur + x / 4 ),_mm_loadu_si128( ref + x / 4 ) );
+						if( _mm_movemask_epi8( equal ) != 0xFFFF )
+						{
+							return true;
+						}
+					}
+					for( ; x < width; x++ )
+					{
+						if( pCur[x].c != pRef[x].c )
+						{
+							return true;
+						}
+					}
+				}
+			}
+			return false;
+		}
+
+		void CopyTile( Color* pDst,unsigned int dstPitch,const Color* pSrc,unsigned int srcPitch,
+			unsigned int width,unsigned int height )
+		{
+			for( unsigned int y = 0; y < height; y++ )
+			{
+				memcpy( &pDst[y * dstPitch],&pSrc[y * srcPitch],width * sizeof( Color ) );
+			}
+		}
+	}
+
+	Encoder::Encoder( unsigned int width,unsigned int height,bool compress )
+		:
+		reference( width,height ),
+		nTilesX( ( width + tileSize - 1 ) / tileSize ),
+		nTilesY( ( height + tileSize - 1 ) / tileSize ),
+		compress( compress ),
+		keyPending( true ),
+		nChanged( 0 )
+	{
+		assert( width > 0 && height > 0 );
+	}
+
+	void Encoder::Encode( const Surface& frame,std::vector<unsigned char>& packet )
+	{
+		PROFILE_FUNCTION();
+		const unsigned int width = reference.GetWidth();
+		const unsigned int height = reference.GetHeight();
+		assert( frame.GetWidth() == width );
+		assert( frame.GetHeight() == height );
+		const size_t start = packet.size();
+		packet.resize( start + headerSize );
+		const Color* const pCur = frame.GetBufferConst();
+		const unsigned int curPitch = frame.GetPixelPitch();
+		Color* const pRef = reference.GetBuffer();
+		const unsigned int refPitch = reference.GetPixelPitch();
+		unsigned int nTiles = 0;
+		for( unsigned int ty = 0; ty < nTilesY; ty++ )
+		{
+			for( unsigned int tx = 0; tx < nTilesX; tx++ )
+			{
+				const unsigned int x0 = tx * tileSize;
+				const unsigned int y0 = ty * tileSize;
+				const unsigned int tileWidth = min( tileSize,width - x0 );
+				const unsigned int tileHeight = min( tileSize,height - y0 );
+				const Color* const pCurTile = &pCur[y0 * curPitch + x0];
+				Color* const pRefTile = &pRef[y0 * refPitch + x0];
+				if( !keyPending && !TileChanged( pCurTile,curPitch,pRefTile,refPitch,tileWidth,tileHeight ) )
+				{
+					continue;
+				}
+				CopyTile( pRefTile,refPitch,pCurTile,curPitch,tileWidth,tileHeight );
+				nTiles++;
+				Append32( packet,ty * nTilesX + tx );
+				const size_t sizePos = packet.size();
+				Append32( packet,0 );
+				const size_t dataStart = packet.size();
+				const unsigned int rawSize = tileWidth * tileHeight * sizeof( Color );
+				if( compress )
+				{
+					FrameCapture::EncodeQoi( pCurTile,tileWidth,tileHeight,curPitch,packet );
+					if( packet.size() - dataStart < rawSize )
+					{
+						Put32( packet,sizePos,(unsigned int)( packet.size() - dataStart ) );
+						continue;
+					}
+					// noise doesn't compress, send it as is
+					packet.resize( dataStart );
+				}
+				packet.resize( dataStart + rawSize );
+				CopyTile( reinterpret_cast<Color*>( &packet[dataStart] ),tileWidth,pCurTile,curPitch,tileWidth,tileHeight );
+				Put32( packet,sizePos,rawSize );
+			}
+		}
+		memcpy( &packet[start],"CHDF",4 );
+		Put32( packet,start + 4,width );
+		Put32( packet,start + 8,height );
+		Put32( packet,start + 12,keyPending ? KeyFrame : 0 );
+		Put32( packet,start + 16,nTiles );
+		Put32( packet,start + 20,(unsigned int)( packet.size() - start - headerSize ) );
+		keyPending = false;
+		nChanged = nTiles;
+	}
+
+	void Encoder::RequestKeyFrame()
+	{
+		keyPending = true;
+	}
+
+	unsigned int Encoder::GetTileCount() const
+	{
+		return nTilesX * nTilesY;
+	}
+
+	unsigned int Encoder::GetChangedTileCount() const
+	{
+		return nChanged;
+	}
+
+	Decoder::Decoder()
+	{}
+
+	size_t Decoder::Decode( const unsigned char* data,size_t size )
+	{
+		PROFILE_FUNCTION();
+		if( size < headerSize || memcmp( data,"CHDF",4 ) != 0 )
+		{
+			return 0;
+		}
+		const unsigned int width = Get32( data + 4 );
+		const unsigned int height = Get32( data + 8 );
+		const unsigned int flags = Get32( data + 12 );
+		const unsigned int nTiles = Get32( data + 16 );
+		const size_t payloadSize = Get32( data + 20 );
+		if( payloadSize > size - headerSize || width == 0 || height == 0 ||
+			width > maxDimension || height > maxDimension )
+		{
+			return 0;
+		}
+		const bool isKey = ( flags & KeyFrame ) != 0;
+		const bool sameSize = pFrame && pFrame->GetWidth() == width && pFrame->GetHeight() == height;
+		if( !isKey && !sameSize )
+		{
+			return 0;
+		}
+		const unsigned int nTilesX = ( width + tileSize - 1 ) / tileSize;
+		const unsigned int nTilesY = ( height + tileSize - 1 ) / tileSize;
+		// every tile takes at least its 8 byte header, so this bounds the size of the frame
+		// a key frame can allocate by the size of the packet; key frames carry every tile
+		if( nTiles > nTilesX * nTilesY || (unsigned long long)nTiles * 8 > payloadSize ||
+			( isKey && nTiles != nTilesX * nTilesY ) )
+		{
+			return 0;
+		}
+		if( !sameSize )
+		{
+			pFrame.reset( new Surface( width,height ) );
+		}
+		Color* const pPixels = pFrame->GetBuffer();
+		const unsigned int pitch = pFrame->GetPixelPitch();
+		// with the count checked above, a key frame misses a tile only if it repeats another
+		std::vector<bool> covered( isKey ? nTiles : 0 );
+		const unsigned char* p = data + headerSize;
+		const unsigned char* const end = p + payloadSize;
+		for( unsigned int i = 0; i < nTiles; i++ )
+		{
+			if( end - p < 8 )
+			{
+				pFrame.reset();
+				return 0;
+			}
+			const unsigned int tile = Get32( p );
+			const size_t tileDataSize = Get32( p + 4 );
+			p += 8;
+			if( tile >= nTilesX * nTilesY || tileDataSize > (size_t)( end - p ) || ( isKey && covered[tile] ) )
+			{
+				pFrame.reset();
+				return 0;
+			}
+			if( isKey )
+			{
+				covered[tile] = true;
+			}
+			const unsigned int x0 = tile % nTilesX * tileSize;
+			const unsigned int y0 = tile / nTilesX * tileSize;
+			const unsigned int tileWidth = min( tileSize,width - x0 );
+			const unsigned int tileHeight = min( tileSize,height - y0 );
+			Color* const pTile = &pPixels[y0 * pitch + x0];
+			if( tileDataSize == tileWidth * tileHeight * sizeof( Color ) )
+			{
+				CopyTile( pTile,pitch,reinterpret_cast<const Color*>( p ),tileWidth,tileWidth,tileHeight );
+			}
+			else if( FrameCapture::DecodeQoi( p,tileDataSize,pTile,tileWidth,tileHeight,pitch ) != tileDataSize )
+			{
+				pFrame.reset();
+				return 0;
+			}
+			p += tileDataSize;
+		}
+		if( p != end )
+		{
+			pFrame.reset();
+			return 0;
+		}
+		return headerSize + payloadSize;
+	}
+
+	bool Decoder::HasFrame() const
+	{
+		return pFrame != nullptr;
+	}
+
+	const Surface& Decoder::GetFrame() const
+	{
+		assert( HasFrame() );
+		return *pFrame;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	FrameDelta.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include "Rect.h"
+#include "Surface.h"
+#include <vector>
+#include <memory>
+
+// frame mirroring by changed tiles: the encoder keeps the last frame it sent, compares
+// the new one against it tile by tile and packs only the tiles that differ
+// packet layout (little endian):
+//   'C' 'H' 'D' 'F', uint32 width, uint32 height, uint32 flags, uint32 nTiles,
+//   uint32 payload bytes, then per tile: uint32 tile index (row major), uint32 size,
+//   data; data is the tile's rows when size is the raw size, a QOI image otherwise
+// packets are self-delimiting, so a file or socket of them back to back is a stream
+namespace FrameDelta
+{
+	static const unsigned int tileSize = 16;
+
+	enum Flags : unsigned int
+	{
+		// every tile is present, decoding can start here
+		KeyFrame = 1
+	};
+
+	class Encoder
+	{
+	public:
+		// compress runs QOI over each changed tile and keeps it if it's smaller
+		Encoder( unsigned int width,unsigned int height,bool compress = true );
+		Encoder( const Encoder& ) = delete;
+		Encoder& operator=( const Encoder& ) = delete;
+		// appends the packet for frame, which must be width x height; the first packet and
+		// the first after RequestKeyFrame carry every tile
+		void Encode( const Surface& frame,std::vector<unsigned char>& packet );
+		// e.g. when a new viewer joins
+		void RequestKeyFrame();
+		unsigned int GetTileCount() const;
+		// in the last packet
+		unsigned int GetChangedTileCount() const;
+	private:
+		Surface reference;
+		unsigned int nTilesX;
+		unsigned int nTilesY;
+		bool compress;
+		bool keyPending;
+		unsigned int nChanged;
+	};
+
+	class Decoder
+	{
+	public:
+		Decoder();
+		Decoder( const Decoder& ) = delete;
+		Decoder& operator=( const Decoder& ) = delete;
+		// applies one whole packet and returns its size, or 0 if it's truncated or a delta
+		// with no key frame of the same size before it (frame untouched) or malformed (frame
+		// dropped until the next key frame, it may be half updated); malformed includes frame
+		// sides above 16384 and key frames that don't carry every tile exactly once
+		size_t Decode( const unsigned char* data,size_t size );
+		bool HasFrame() const;
+		const Surface& GetFrame() const;
+	private:
+		std::unique_ptr<Surface> pFrame;
+	};
+}
\ No newline at end of file
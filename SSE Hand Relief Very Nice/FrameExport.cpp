@@ -0,0 +1,319 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	FrameExport.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "FrameExport.h"
+#include <new>
+#include <string.h>
+#include <assert.h>
+
+static_assert( sizeof( FrameExportHeader ) <= FrameExportHeader::slotOffset,"FrameExportHeader outgrew its space" );
+static_assert( sizeof( FrameExportSlot ) <= FrameExportHeader::pixelOffset,"FrameExportSlot outgrew its space" );
+
+namespace
+{
+	std::wstring ReadyEventName( const std::wstring& name,unsigned int parity )
+	{
+		return name + ( parity == 0 ? L"-ready0" : L"-ready1" );
+	}
+}
+
+FrameExport::FrameExport( const std::wstring& name,unsigned int width,unsigned int height,unsigned int nSlots )
+	:
+	hMapping( NULL ),
+	pView( nullptr ),
+	pHeader( nullptr ),
+	nextFrame( 0 ),
+	writing( false )
+{
+	assert( nSlots >= 2 );
+	hReady[0] = NULL;
+	hReady[1] = NULL;
+	// cache line aligned rows and slots
+	const unsigned int pitch = ( width * sizeof( Color ) + 63 ) & ~63u;
+	const unsigned int slotSize = FrameExportHeader::pixelOffset + pitch * height;
+	const unsigned long long size = FrameExportHeader::slotOffset + (unsigned long long)slotSize * nSlots;
+	hMapping = CreateFileMappingW( INVALID_HANDLE_VALUE,NULL,PAGE_READWRITE,
+		(DWORD)( size >> 32 ),(DWORD)size,name.c_str() );
+	if( hMapping == NULL )
+	{
+		return;
+	}
+	// fails if the name belongs to an older, smaller mapping
+	pView = (BYTE*)MapViewOfFile( hMapping,FILE_MAP_ALL_ACCESS,0,0,(size_t)size );
+	for( unsigned int i = 0; i < 2; i++ )
+	{
+		hReady[i] = CreateEventW( NULL,TRUE,FALSE,ReadyEventName( name,i ).c_str() );
+	}
+	if( pView == nullptr || hReady[0] == NULL || hReady[1] == NULL )
+	{
+		return;
+	}
+	// readers must not attach to a mapping that is being (re)initialized
+	memset( pView,0,sizeof( FrameExportHeader().magic ) );
+	for( unsigned int i = 0; i < nSlots; i++ )
+	{
+		FrameExportSlot* const pSlot = new( pView + FrameExportHeader::slotOffset + i * slotSize ) FrameExportSlot;
+		pSlot->frame.store( 0,std::memory_order_relaxed );
+	}
+	pHeader = new( pView ) FrameExportHeader;
+	pHeader->headerVersion = FrameExportHeader::version;
+	pHeader->width = width;
+	pHeader->height = height;
+	pHeader->pitch = pitch;
+	pHeader->nSlots = nSlots;
+	pHeader->slotSize = slotSize;
+	pHeader->nPublished.store( 0,std::memory_order_relaxed );
+	ResetEvent( hReady[0] );
+	ResetEvent( hReady[1] );
+	// readers check the magic, so it goes in last
+	std::atomic_thread_fence( std::memory_order_release );
+	memcpy( pHeader->magic,"CHFX",4 );
+}
+
+FrameExport::~FrameExport()
+{
+	if( pView )
+	{
+		UnmapViewOfFile( pView );
+	}
+	for( unsigned int i = 0; i < 2; i++ )
+	{
+		if( hReady[i] )
+		{
+			CloseHandle( hReady[i] );
+		}
+	}
+	if( hMapping )
+	{
+		CloseHandle( hMapping );
+	}
+}
+
+bool FrameExport::IsValid() const
+{
+	return pHeader != nullptr;
+}
+
+BYTE* FrameExport::BeginFrame()
+{
+	assert( IsValid() );
+	assert( !writing );
+	writing = true;
+	// seqlock write side: mark the slot, then fence so the pixels can't be seen first
+	FrameExportSlot& slot = GetSlot( nextFrame );
+	slot.frame.store( 0,std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+	return reinterpret_cast<BYTE*>( &slot ) + FrameExportHeader::pixelOffset;
+}
+
+void FrameExport::EndFrame()
+{
+	assert( writing );
+	writing = false;
+	const unsigned int frame = nextFrame++;
+	GetSlot( frame ).frame.store( frame + 1,std::memory_order_release );
+	ResetEvent( hReady[( frame + 1 ) & 1] );
+	pHeader->nPublished.store( frame + 1,std::memory_order_release );
+	SetEvent( hReady[frame & 1] );
+}
+
+unsigned int FrameExport::GetPitch() const
+{
+	return pHeader->pitch;
+}
+
+unsigned int FrameExport::GetWidth() const
+{
+	return pHeader->width;
+}
+
+unsigned int FrameExport::GetHeight() const
+{
+	return pHeader->height;
+}
+
+FrameExportSlot& FrameExport::GetSlot( unsigned int frame ) const
+{
+	return *reinterpret_cast<FrameExportSlot*>(
+		pView + FrameExportHeader::slotOffset + ( frame % pHeader->nSlots ) * pHeader->slotSize );
+}
+
+FrameExportReader::FrameExportReader( const std::wstring& name )
+	:
+	hMapping( NULL ),
+	pView( nullptr ),
+	pHeader( nullptr ),
+	width( 0 ),
+	height( 0 ),
+	pitch( 0 ),
+	nSlots( 0 ),
+	slotSize( 0 ),
+	nSeen( 0 ),
+	frameNumber( 0 )
+{
+	hReady[0] = NULL;
+	hReady[1] = NULL;
+	hMapping = OpenFileMappingW( FILE_MAP_READ,FALSE,name.c_str() );
+	if( hMapping == NULL )
+	{
+		return;
+	}
+	pView = (BYTE*)MapViewOfFile( hMapping,FILE_MAP_READ,0,0,0 );
+	for( unsigned int i = 0; i < 2; i++ )
+	{
+		hReady[i] = OpenEventW( SYNCHRONIZE,FALSE,ReadyEventName( name,i ).c_str() );
+	}
+	if( pView == nullptr || hReady[0] == NULL || hReady[1] == NULL )
+	{
+		return;
+	}
+	// the mapping belongs to another process, so nothing in it is trusted until the header
+	// is known to describe slots that fit inside the view
+	MEMORY_BASIC_INFORMATION info;
+	if( VirtualQuery( pView,&info,sizeof( info ) ) == 0 || info.RegionSize < sizeof( FrameExportHeader ) )
+	{
+		return;
+	}
+	const FrameExportHeader* const pCandidate = reinterpret_cast<const FrameExportHeader*>( pView );
+	if( memcmp( pCandidate->magic,"CHFX",4 ) != 0 || pCandidate->headerVersion != FrameExportHeader::version )
+	{
+		return;
+	}
+	std::atomic_thread_fence( std::memory_order_acquire );
+	// read each field once, a check against one value and use of another would be a race
+	const unsigned int candidateWidth = pCandidate->width;
+	const unsigned int candidateHeight = pCandidate->height;
+	const unsigned int candidatePitch = pCandidate->pitch;
+	const unsigned int candidateSlots = pCandidate->nSlots;
+	const unsigned int candidateSlotSize = pCandidate->slotSize;
+	const unsigned long long rowBytes = (unsigned long long)candidateWidth * sizeof( Color );
+	const unsigned long long slotBytes = FrameExportHeader::pixelOffset +
+		(unsigned long long)candidatePitch * candidateHeight;
+	const unsigned long long viewBytes = FrameExportHeader::slotOffset +
+		(unsigned long long)candidateSlotSize * candidateSlots;
+	if( candidateSlots < 2 || candidatePitch < rowBytes || candidatePitch % sizeof( Color ) != 0 ||
+		candidateSlotSize < slotBytes || candidateSlotSize % sizeof( FrameExportSlot ) != 0 ||
+		viewBytes > info.RegionSize )
+	{
+		return;
+	}
+	// only these validated copies are used from here on, the producer may rewrite the header
+	width = candidateWidth;
+	height = candidateHeight;
+	pitch = candidatePitch;
+	nSlots = candidateSlots;
+	slotSize = candidateSlotSize;
+	pHeader = pCandidate;
+}
+
+FrameExportReader::~FrameExportReader()
+{
+	if( pView )
+	{
+		UnmapViewOfFile( pView );
+	}
+	for( unsigned int i = 0; i < 2; i++ )
+	{
+		if( hReady[i] )
+		{
+			CloseHandle( hReady[i] );
+		}
+	}
+	if( hMapping )
+	{
+		CloseHandle( hMapping );
+	}
+}
+
+bool FrameExportReader::IsValid() const
+{
+	return pHeader != nullptr;
+}
+
+const Color* FrameExportReader::WaitFrame( unsigned int timeoutMs )
+{
+	assert( IsValid() );
+	const DWORD start = GetTickCount();
+	while( true )
+	{
+		const unsigned int nPublished = pHeader->nPublished.load( std::memory_order_acquire );
+		if( nPublished == 0 || nPublished < nSeen )
+		{
+			// the producer re-created the mapping and counts from 0 again; its slots are
+			// reset too, so wait for its first frame
+			nSeen = 0;
+		}
+		if( nPublished != nSeen )
+		{
+			const unsigned int frame = nPublished - 1;
+			const FrameExportSlot& slot = GetSlot( frame );
+			if( slot.frame.load( std::memory_order_acquire ) == nPublished )
+			{
+				nSeen = nPublished;
+				frameNumber = frame;
+				return reinterpret_cast<const Color*>( reinterpret_cast<const BYTE*>( &slot ) + FrameExportHeader::pixelOffset );
+			}
+			// the producer lapped us between the two loads, take the newer frame
+			continue;
+		}
+		const DWORD elapsed = GetTickCount() - start;
+		if( elapsed >= timeoutMs )
+		{
+			return nullptr;
+		}
+		// if the producer publishes twice between the load and the wait, ready[nPublished & 1]
+		// is set and reset again before we wait on it; waiting in short slices and reloading
+		// bounds that missed wakeup to one slice instead of a frame or the whole timeout
+		WaitForSingleObject( hReady[nPublished & 1],min( timeoutMs - elapsed,(DWORD)maxWaitSliceMs ) );
+	}
+}
+
+bool FrameExportReader::IsIntact() const
+{
+	// seqlock read side: the pixel reads must complete before the recheck
+	std::atomic_thread_fence( std::memory_order_acquire );
+	return GetSlot( frameNumber ).frame.load( std::memory_order_relaxed ) == frameNumber + 1;
+}
+
+unsigned int FrameExportReader::GetFrameNumber() const
+{
+	return frameNumber;
+}
+
+unsigned int FrameExportReader::GetPitch() const
+{
+	return pitch;
+}
+
+unsigned int FrameExportReader::GetWidth() const
+{
+	return width;
+}
+
+unsigned int FrameExportReader::GetHeight() const
+{
+	return height;
+}
+
+const FrameExportSlot& FrameExportReader::GetSlot( unsigned int frame ) const
+{
+	return *reinterpret_cast<const FrameExportSlot*>(
+		pView + FrameExportHeader::slotOffset + ( frame % nSlots ) * slotSize );
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	FrameExport.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Colors.h"
+#include <Windows.h>
+#include <atomic>
+#include <string>
+
+// finished frames published to other processes through a named shared mapping
+// the mapping is a FrameExportHeader followed by nSlots slots; slot i starts at
+// slotOffset + i * slotSize with a FrameExportSlot, and its rows start pixelOffset bytes
+// into the slot, pitch bytes apart
+// frame n (counting from 0) goes into slot n % nSlots; its FrameExportSlot::frame is a
+// seqlock, 0 while the producer writes and n + 1 once the frame is complete, so a reader
+// can use the pixels in place and then check that the slot wasn't reused under it
+// the producer pulses two manual-reset events named <name>-ready0 / -ready1: publishing
+// frame n resets ready[( n + 1 ) & 1] and then sets ready[n & 1], so a reader that has
+// seen n + 1 frames waits on ready[( n + 1 ) & 1]
+struct FrameExportHeader
+{
+	static const unsigned int version = 1;
+	static const unsigned int slotOffset = 64;
+	static const unsigned int pixelOffset = 64;
+	// 'C' 'H' 'F' 'X'
+	char magic[4];
+	unsigned int headerVersion;
+	unsigned int width;
+	unsigned int height;
+	unsigned int pitch;
+	unsigned int nSlots;
+	unsigned int slotSize;
+	// frames published so far (wraps after 2^32)
+	std::atomic<unsigned int> nPublished;
+};
+
+struct FrameExportSlot
+{
+	std::atomic<unsigned int> frame;
+};
+
+// producer side, see D3DGraphics::SetFrameExport
+class FrameExport
+{
+public:
+	// creates the mapping; an existing one of the same name is reused only if it's big enough
+	FrameExport( const std::wstring& name,unsigned int width,unsigned int height,unsigned int nSlots = 3 );
+	FrameExport( const FrameExport& ) = delete;
+	FrameExport& operator=( const FrameExport& ) = delete;
+	~FrameExport();
+	bool IsValid() const;
+	// destination for the next frame's rows (GetPitch bytes apart), publish with EndFrame
+	BYTE* BeginFrame();
+	void EndFrame();
+	unsigned int GetPitch() const;
+	unsigned int GetWidth() const;
+	unsigned int GetHeight() const;
+private:
+	FrameExportSlot& GetSlot( unsigned int frame ) const;
+private:
+	HANDLE hMapping;
+	HANDLE hReady[2];
+	BYTE* pView;
+	FrameExportHeader* pHeader;
+	unsigned int nextFrame;
+	bool writing;
+};
+
+// consumer side, e.g. for a capture agent or test oracle in another process
+class FrameExportReader
+{
+public:
+	// IsValid is false unless the mapping holds a complete header whose slots fit in it
+	FrameExportReader( const std::wstring& name );
+	FrameExportReader( const FrameExportReader& ) = delete;
+	FrameExportReader& operator=( const FrameExportReader& ) = delete;
+	~FrameExportReader();
+	bool IsValid() const;
+	// the newest frame if it's one this reader hasn't returned yet, else waits up to
+	// timeoutMs for the next; nullptr on timeout; if the producer restarts, the reader
+	// starts over with its first frame
+	// the rows are the producer's slot, so they stay put for about nSlots - 1 frames:
+	// use them in place and confirm with IsIntact, or copy them out
+	const Color* WaitFrame( unsigned int timeoutMs );
+	// false if the producer started overwriting the last returned frame
+	bool IsIntact() const;
+	// number of the last returned frame; gaps mean frames were skipped
+	unsigned int GetFrameNumber() const;
+	unsigned int GetPitch() const;
+	unsigned int GetWidth() const;
+	unsigned int GetHeight() const;
+private:
+	const FrameExportSlot& GetSlot( unsigned int frame ) const;
+private:
+	static const unsigned int maxWaitSliceMs = 2;
+	HANDLE hMapping;
+	HANDLE hReady[2];
+	BYTE* pView;
+	// only nPublished and the slots' frame numbers are read from the shared header after
+	// construction; the geometry is the copy validated there
+	const FrameExportHeader* pHeader;
+	unsigned int width;
+	unsigned int height;
+	unsigned int pitch;
+	unsigned int nSlots;
+	unsigned int slotSize;
+	unsigned int nSeen;
+	unsigned int frameNumber;
+};
\ No newline at end of file
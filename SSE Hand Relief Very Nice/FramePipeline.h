@@ -0,0 +1,103 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	FramePipeline.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+
+// bounded hand-off of per-frame state from one producer stage to one consumer stage
+// slots are used round robin, so with two slots the producer fills frame N+1
+// while the consumer is still reading frame N, and blocks if it gets further ahead
+template< class T,unsigned int nSlots = 2 >
+class FramePipeline
+{
+public:
+	FramePipeline()
+		:
+		nWritten( 0 ),
+		nRead( 0 ),
+		nReleased( 0 ),
+		stopped( false )
+	{}
+	FramePipeline( const FramePipeline& ) = delete;
+	FramePipeline& operator=( const FramePipeline& ) = delete;
+	// producer side: returns the next free slot (blocking while all slots are in flight)
+	// or nullptr once the pipeline has been stopped
+	T* BeginWrite()
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+		slotFreed.wait( lock,[this](){ return stopped || nWritten - nReleased < nSlots; } );
+		if( stopped )
+		{
+			return nullptr;
+		}
+		return &slots[nWritten % nSlots];
+	}
+	// producer side: queue the slot returned by BeginWrite for the consumer
+	void EndWrite()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			nWritten++;
+		}
+		slotQueued.notify_one();
+	}
+	// consumer side: returns the oldest queued slot (blocking while the queue is empty)
+	// or nullptr once the pipeline has been stopped
+	const T* BeginRead()
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+		slotQueued.wait( lock,[this](){ return stopped || nRead < nWritten; } );
+		if( stopped )
+		{
+			return nullptr;
+		}
+		return &slots[nRead++ % nSlots];
+	}
+	// consumer side: hand the slot returned by BeginRead back to the producer
+	void EndRead()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			nReleased++;
+		}
+		slotFreed.notify_one();
+	}
+	// wake both stages and make every subsequent Begin* fail
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			stopped = true;
+		}
+		slotFreed.notify_all();
+		slotQueued.notify_all();
+	}
+private:
+	T slots[nSlots];
+	unsigned long long nWritten;
+	unsigned long long nRead;
+	unsigned long long nReleased;
+	bool stopped;
+	std::mutex mutex;
+	std::condition_variable slotFreed;
+	std::condition_variable slotQueued;
+};
\ No newline at end of file
@@ -21,31 +21,128 @@
 #pragma once
 
 #include "Timer.h"
+#include "Histogram.h"
+#include "PerfCounters.h"
 #include <float.h>
+#include <limits.h>
 #include <sstream>
 #include <iomanip>
+#include <ostream>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
 
 class FrameTimer
 {
+public:
+	// summary of one export interval, times in milliseconds
+	struct Stats
+	{
+		unsigned long long nFrames;
+		float avg;
+		float min;
+		float max;
+		float p50;
+		float p90;
+		float p99;
+		float p999;
+		// mean absolute change in frame time between consecutive frames
+		float jitter;
+		// hardware counter figures, 0 when counters are off or the event is unavailable
+		float cyclesPerPixel;
+		float bytesPerCycle;
+		float instructionsPerCycle;
+		float l1MissesPerPixel;
+		float llcMissesPerPixel;
+		float branchMissesPerPixel;
+	};
 public:
 	FrameTimer()
 		:
-	timeMin( FLT_MAX ),
-	timeMax( 0.0f ),
-	timeSum( 0.0f ),
-	lastMin( 0.0f ),
-	lastMax( 0.0f ),
-	lastAvg( 0.0f ),
-	frameCount( 0 )
-	{}
+	timeMin( ULLONG_MAX ),
+	timeMax( 0 ),
+	timeSum( 0 ),
+	lastMin( 0 ),
+	lastMax( 0 ),
+	lastSum( 0 ),
+	frameCount( 0 ),
+	prevFrameTime( 0 ),
+	workPixels( 0 ),
+	workBytes( 0 ),
+	sessionMin( ULLONG_MAX ),
+	sessionMax( 0 ),
+	intervalMin( ULLONG_MAX ),
+	intervalMax( 0 ),
+	jitterSum( 0 ),
+	jitterCount( 0 ),
+	exportStop( false )
+	{
+		for( int i = 0; i < PerfCounters::nEvents; i++ )
+		{
+			counterTotals[i] = 0;
+		}
+		invFreqMilli = 1000.0 / (double)timer.GetFrequency();
+	}
+	~FrameTimer()
+	{
+		StopExport();
+	}
+	FrameTimer( const FrameTimer& ) = delete;
+	FrameTimer& operator=( const FrameTimer& ) = delete;
+	// sample hardware counters around every frame as well; pixels and bytes are the amount
+	// of work the timed region does per frame and turn the counts into per pixel figures
+	// (call before StartExport); the counters follow the thread that calls StartFrame
+	// (the render thread when the frame loop is pipelined), see PerfCounters
+	void EnableCounters( unsigned long long pixelsPerFrame,unsigned long long bytesPerFrame )
+	{
+		pCounters.reset( new PerfCounters );
+		workPixels = pixelsPerFrame;
+		workBytes = bytesPerFrame;
+	}
 	void StartFrame()
 	{		
+		if( pCounters )
+		{
+			pCounters->Start();
+		}
 		timer.StartWatch();
 	}
+	// records the frame into the histogram (lock-free, no formatting)
+	// returns true every nFramesAvg frames when GetAvg/GetMin/GetMax have been refreshed
 	bool StopFrame()
 	{
 		timer.StopWatch();
-		const float frameTime = timer.GetTimeMilli();
+		const unsigned long long frameTime = timer.GetTicks();
+		if( pCounters )
+		{
+			const PerfCounters::Sample sample = pCounters->Stop();
+			counterSum += sample;
+			counterTotals[PerfCounters::Cycles].fetch_add( sample.cycles,std::memory_order_relaxed );
+			counterTotals[PerfCounters::Instructions].fetch_add( sample.instructions,std::memory_order_relaxed );
+			counterTotals[PerfCounters::L1Misses].fetch_add( sample.l1Misses,std::memory_order_relaxed );
+			counterTotals[PerfCounters::LlcMisses].fetch_add( sample.llcMisses,std::memory_order_relaxed );
+			counterTotals[PerfCounters::BranchMisses].fetch_add( sample.branchMisses,std::memory_order_relaxed );
+		}
+
+		histogram.Record( frameTime );
+		AtomicMin( sessionMin,frameTime );
+		AtomicMax( sessionMax,frameTime );
+		AtomicMin( intervalMin,frameTime );
+		AtomicMax( intervalMax,frameTime );
+		if( prevFrameTime != 0 )
+		{
+			const unsigned long long delta = frameTime > prevFrameTime ?
+				frameTime - prevFrameTime : prevFrameTime - frameTime;
+			jitterSum.fetch_add( delta,std::memory_order_relaxed );
+			jitterCount.fetch_add( 1,std::memory_order_relaxed );
+		}
+		prevFrameTime = frameTime;
+
 		timeSum += frameTime;
 		timeMin = min( timeMin,frameTime );
 		timeMax = max( timeMax,frameTime );
@@ -56,16 +153,19 @@ public:
 		}
 		else
 		{
-			lastAvg = timeSum / (float)nFramesAvg;
+			lastSum = timeSum;
 			lastMin = timeMin;
 			lastMax = timeMax;
-			timeSum = 0.0f;
-			timeMin = FLT_MAX;
-			timeMax = 0.0f;
+			lastCounters = counterSum;
+			counterSum = PerfCounters::Sample();
+			timeSum = 0;
+			timeMin = ULLONG_MAX;
+			timeMax = 0;
 			frameCount = 0;
 			return true;
 		}
 	}
+	// formats on the calling thread; prefer StartExport for anything that runs every frame
 	template< class T >
 	bool StopFrame( T& output )
 	{
@@ -78,32 +178,252 @@ public:
 			std::wstringstream ss;
 			ss.precision( 3 );
 			ss << L"Avg: [" << std::fixed << GetAvg() << L"] Min: [" << GetMin()
-				<< L"] Max: [" << GetMax() << L"]" << std::endl;
+				<< L"] Max: [" << GetMax() << L"]";
+			if( pCounters )
+			{
+				ss << L" Cyc/px: [" << GetCyclesPerPixel() << L"] B/cyc: [" << GetBytesPerCycle() << L"]";
+				if( pCounters->HasEvent( PerfCounters::Instructions ) )
+				{
+					ss << L" IPC: [" << ( lastCounters.cycles > 0 ?
+						(float)lastCounters.instructions / (float)lastCounters.cycles : 0.0f ) << L"]";
+				}
+				if( pCounters->HasEvent( PerfCounters::L1Misses ) )
+				{
+					ss << L" L1 miss/px: [" << GetPerPixel( lastCounters.l1Misses ) << L"]";
+				}
+				if( pCounters->HasEvent( PerfCounters::LlcMisses ) )
+				{
+					ss << L" LLC miss/px: [" << GetPerPixel( lastCounters.llcMisses ) << L"]";
+				}
+				if( pCounters->HasEvent( PerfCounters::BranchMisses ) )
+				{
+					ss << L" Br miss/px: [" << GetPerPixel( lastCounters.branchMisses ) << L"]";
+				}
+				if( !pCounters->HasCoreCycles() )
+				{
+					ss << L" (TSC)";
+				}
+			}
+			ss << std::endl;
 			output << ss.str();
 			return true;
 		}
 	}
 	float GetAvg() const
 	{
-		return lastAvg;
+		return TicksToMilli( lastSum ) / (float)nFramesAvg;
 	}
 	float GetMin() const
 	{
-		return lastMin;
+		return TicksToMilli( lastMin );
 	}
 	float GetMax() const
 	{
-		return lastMax;
+		return TicksToMilli( lastMax );
+	}
+	// counter figures of the last nFramesAvg window (EnableCounters first)
+	float GetCyclesPerPixel() const
+	{
+		return GetPerPixel( lastCounters.cycles );
+	}
+	float GetBytesPerCycle() const
+	{
+		return lastCounters.cycles > 0 ?
+			(float)( (double)( workBytes * nFramesAvg ) / (double)lastCounters.cycles ) : 0.0f;
+	}
+	const PerfCounters::Sample& GetCounters() const
+	{
+		return lastCounters;
+	}
+	// percentiles over every frame since construction
+	Stats GetSessionStats() const
+	{
+		return MakeStats( histogram.Take(),sessionMin.load(),sessionMax.load(),
+			jitterSum.load(),jitterCount.load(),LoadCounterTotals() );
+	}
+	// spawns a thread that every periodMilli summarizes the frames of the interval into
+	// the in-memory ring (see GetExportedStats) and, if pOutput is not null, writes them there
+	// pOutput must outlive the FrameTimer
+	void StartExport( std::wostream* pOutput,unsigned int periodMilli = 1000 )
+	{
+		StopExport();
+		exportStop = false;
+		exportThread = std::thread( &FrameTimer::ExportLoop,this,pOutput,periodMilli );
+	}
+	void StopExport()
+	{
+		if( exportThread.joinable() )
+		{
+			{
+				std::lock_guard<std::mutex> lock( exportMutex );
+				exportStop = true;
+			}
+			exportWake.notify_all();
+			exportThread.join();
+		}
+	}
+	// most recent export intervals, oldest first
+	std::vector<Stats> GetExportedStats() const
+	{
+		std::lock_guard<std::mutex> lock( ringMutex );
+		return std::vector<Stats>( ring.begin(),ring.end() );
 	}
+private:
+	void ExportLoop( std::wostream* pOutput,unsigned int periodMilli )
+	{
+		Histogram::Snapshot last;
+		unsigned long long lastJitterSum = 0;
+		unsigned long long lastJitterCount = 0;
+		PerfCounters::Sample lastCounterTotals;
+		std::unique_lock<std::mutex> lock( exportMutex );
+		while( !exportStop )
+		{
+			exportWake.wait_for( lock,std::chrono::milliseconds( periodMilli ),
+				[this](){ return exportStop; } );
+			lock.unlock();
 
+			const Histogram::Snapshot now = histogram.Take();
+			const unsigned long long nowJitterSum = jitterSum.load();
+			const unsigned long long nowJitterCount = jitterCount.load();
+			const PerfCounters::Sample nowCounterTotals = LoadCounterTotals();
+			const Stats stats = MakeStats( now - last,
+				intervalMin.exchange( ULLONG_MAX ),intervalMax.exchange( 0 ),
+				nowJitterSum - lastJitterSum,nowJitterCount - lastJitterCount,
+				nowCounterTotals - lastCounterTotals );
+			last = now;
+			lastCounterTotals = nowCounterTotals;
+			lastJitterSum = nowJitterSum;
+			lastJitterCount = nowJitterCount;
+			if( stats.nFrames > 0 )
+			{
+				{
+					std::lock_guard<std::mutex> ringLock( ringMutex );
+					ring.push_back( stats );
+					if( ring.size() > ringSize )
+					{
+						ring.pop_front();
+					}
+				}
+				if( pOutput )
+				{
+					Write( *pOutput,stats );
+				}
+			}
+
+			lock.lock();
+		}
+	}
+	Stats MakeStats( const Histogram::Snapshot& snap,unsigned long long minTicks,
+		unsigned long long maxTicks,unsigned long long sumJitter,unsigned long long nJitter,
+		const PerfCounters::Sample& counters ) const
+	{
+		Stats stats;
+		stats.nFrames = snap.GetTotal();
+		stats.avg = stats.nFrames > 0 ?
+			TicksToMilli( snap.GetSum() ) / (float)stats.nFrames : 0.0f;
+		stats.min = stats.nFrames > 0 ? TicksToMilli( minTicks ) : 0.0f;
+		stats.max = TicksToMilli( maxTicks );
+		stats.p50 = TicksToMilli( snap.Percentile( 0.5 ) );
+		stats.p90 = TicksToMilli( snap.Percentile( 0.9 ) );
+		stats.p99 = TicksToMilli( snap.Percentile( 0.99 ) );
+		stats.p999 = TicksToMilli( snap.Percentile( 0.999 ) );
+		stats.jitter = nJitter > 0 ? TicksToMilli( sumJitter ) / (float)nJitter : 0.0f;
+		const double pixels = (double)( workPixels * stats.nFrames );
+		const double cycles = (double)counters.cycles;
+		stats.cyclesPerPixel = pixels > 0.0 ? (float)( cycles / pixels ) : 0.0f;
+		stats.bytesPerCycle = cycles > 0.0 ? (float)( (double)( workBytes * stats.nFrames ) / cycles ) : 0.0f;
+		stats.instructionsPerCycle = cycles > 0.0 ? (float)( (double)counters.instructions / cycles ) : 0.0f;
+		stats.l1MissesPerPixel = pixels > 0.0 ? (float)( (double)counters.l1Misses / pixels ) : 0.0f;
+		stats.llcMissesPerPixel = pixels > 0.0 ? (float)( (double)counters.llcMisses / pixels ) : 0.0f;
+		stats.branchMissesPerPixel = pixels > 0.0 ? (float)( (double)counters.branchMisses / pixels ) : 0.0f;
+		return stats;
+	}
+	PerfCounters::Sample LoadCounterTotals() const
+	{
+		PerfCounters::Sample s;
+		s.cycles = counterTotals[PerfCounters::Cycles].load( std::memory_order_relaxed );
+		s.instructions = counterTotals[PerfCounters::Instructions].load( std::memory_order_relaxed );
+		s.l1Misses = counterTotals[PerfCounters::L1Misses].load( std::memory_order_relaxed );
+		s.llcMisses = counterTotals[PerfCounters::LlcMisses].load( std::memory_order_relaxed );
+		s.branchMisses = counterTotals[PerfCounters::BranchMisses].load( std::memory_order_relaxed );
+		return s;
+	}
+	static void Write( std::wostream& output,const Stats& stats )
+	{
+		std::wstringstream ss;
+		ss.precision( 3 );
+		ss << L"Avg: [" << std::fixed << stats.avg << L"] Min: [" << stats.min
+			<< L"] Max: [" << stats.max << L"] P50: [" << stats.p50
+			<< L"] P90: [" << stats.p90 << L"] P99: [" << stats.p99
+			<< L"] P99.9: [" << stats.p999 << L"] Jitter: [" << stats.jitter
+			<< L"] Frames: [" << stats.nFrames << L"]";
+		if( stats.cyclesPerPixel > 0.0f )
+		{
+			ss << L" Cyc/px: [" << stats.cyclesPerPixel << L"] B/cyc: [" << stats.bytesPerCycle << L"]";
+		}
+		if( stats.instructionsPerCycle > 0.0f )
+		{
+			ss << L" IPC: [" << stats.instructionsPerCycle << L"] L1 miss/px: [" << stats.l1MissesPerPixel
+				<< L"] LLC miss/px: [" << stats.llcMissesPerPixel
+				<< L"] Br miss/px: [" << stats.branchMissesPerPixel << L"]";
+		}
+		ss << std::endl;
+		output << ss.str();
+	}
+	float GetPerPixel( unsigned long long count ) const
+	{
+		return workPixels > 0 ?
+			(float)( (double)count / (double)( workPixels * nFramesAvg ) ) : 0.0f;
+	}
+	float TicksToMilli( unsigned long long ticks ) const
+	{
+		return (float)( (double)ticks * invFreqMilli );
+	}
+	static void AtomicMin( std::atomic<unsigned long long>& target,unsigned long long val )
+	{
+		unsigned long long cur = target.load( std::memory_order_relaxed );
+		while( val < cur && !target.compare_exchange_weak( cur,val,std::memory_order_relaxed ) )
+		{}
+	}
+	static void AtomicMax( std::atomic<unsigned long long>& target,unsigned long long val )
+	{
+		unsigned long long cur = target.load( std::memory_order_relaxed );
+		while( val > cur && !target.compare_exchange_weak( cur,val,std::memory_order_relaxed ) )
+		{}
+	}
 private:
 	const int nFramesAvg = 20;
+	static const size_t ringSize = 64;
 	Timer timer;
-	float timeSum;
-	float timeMin;
-	float timeMax;
+	double invFreqMilli;
+	// fixed window for GetAvg/GetMin/GetMax (frame thread only)
+	unsigned long long timeSum;
+	unsigned long long timeMin;
+	unsigned long long timeMax;
 	int frameCount;
-	float lastMin;
-	float lastMax;
-	float lastAvg;
+	unsigned long long lastMin;
+	unsigned long long lastMax;
+	unsigned long long lastSum;
+	unsigned long long prevFrameTime;
+	// optional hardware counters (frame thread only)
+	std::unique_ptr<PerfCounters> pCounters;
+	unsigned long long workPixels;
+	unsigned long long workBytes;
+	PerfCounters::Sample counterSum;
+	PerfCounters::Sample lastCounters;
+	// shared with the export thread
+	Histogram histogram;
+	std::atomic<unsigned long long> sessionMin;
+	std::atomic<unsigned long long> sessionMax;
+	std::atomic<unsigned long long> intervalMin;
+	std::atomic<unsigned long long> intervalMax;
+	std::atomic<unsigned long long> jitterSum;
+	std::atomic<unsigned long long> jitterCount;
+	std::atomic<unsigned long long> counterTotals[PerfCounters::nEvents];
+	std::thread exportThread;
+	std::mutex exportMutex;
+	std::condition_variable exportWake;
+	bool exportStop;
+	std::deque<Stats> ring;
+	mutable std::mutex ringMutex;
 };
\ No newline at end of file
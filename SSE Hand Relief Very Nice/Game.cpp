@@ -24,7 +24,7 @@
 #include <iomanip>
 #include <random>
 
-Game::Game( HWND hWnd,KeyboardServer& kServer,MouseServer& mServer )
+Game::Game( HWND hWnd,KeyboardServer& kServer,MouseServer& mServer,bool pipelined )
 	:
 	gfx( hWnd ),
 	kbd( kServer ),
@@ -33,45 +33,139 @@ Game::Game( HWND hWnd,KeyboardServer& kServer,MouseServer& mServer )
 	bees( Surface::FromFile( L"bees.jpg" ) ),
 	marle( Surface::FromFile( L"marle.png" ) ),
 	flare( Surface::FromFile( L"flare.png" ) ),
-	logFile( L"logfile.txt" )
+	logFile( L"logfile.txt" ),
+	pipelined( pipelined ),
+	nScreenshots( 0 )
 {
+	// the png sprites are mostly fully transparent or fully opaque, which per-pixel alpha
+	// compositing skips / plain copies a tile at a time
+	dice.EnableOpacityTiles();
+	marle.EnableOpacityTiles();
+	flare.EnableOpacityTiles();
+	// bench workload is the Copy in ComposeFrame: one read and one write per pixel
+	ft.EnableCounters( D3DGraphics::screenWidth * D3DGraphics::screenHeight,
+		D3DGraphics::screenWidth * D3DGraphics::screenHeight * sizeof( Color ) * 2 );
+	// frame stats are summarized and written to the log off the frame thread
+	ft.StartExport( &logFile );
+	if( pipelined )
+	{
+		// from here on the device and sysBuffer are only touched by the render thread
+		renderThread = std::thread( &Game::RenderLoop,this );
+	}
 }
 
 Game::~Game()
 {
+	if( pipelined )
+	{
+		pipeline.Stop();
+		renderThread.join();
+	}
+	PROFILE_DUMP( L"profile.json" );
 }
 
 void Game::Go()
 {
-	gfx.BeginFrame();
-	UpdateModel();
-	ComposeFrame();
-	gfx.EndFrame();
+	PROFILE_FUNCTION();
+	if( !pipelined )
+	{
+		gfx.BeginFrame();
+		UpdateModel( model );
+		ComposeFrame( model );
+		gfx.EndFrame();
+	}
+	else
+	{
+		// update frame N+1 here on the message thread while the render thread is
+		// composing / presenting frame N; blocks when the renderer falls two frames behind
+		UpdateModel( model );
+		if( Model* const pSlot = pipeline.BeginWrite() )
+		{
+			*pSlot = model;
+			pipeline.EndWrite();
+		}
+	}
+}
+
+void Game::RenderLoop()
+{
+	while( const Model* const pModel = pipeline.BeginRead() )
+	{
+		PROFILE_ZONE( "Game::RenderFrame" );
+		gfx.BeginFrame();
+		ComposeFrame( *pModel );
+		// model slot is not needed for present, so give it back before waiting on vsync
+		pipeline.EndRead();
+		gfx.EndFrame();
+	}
 }
 
-void Game::UpdateModel()
+void Game::UpdateModel( Model& model )
 {
+	PROFILE_FUNCTION();
+	model.screenshot = false;
+	while( !kbd.KeyEmpty() )
+	{
+		const KeyEvent e = kbd.ReadKey();
+		if( e.IsPress() && e.GetCode() == VK_F12 )
+		{
+			model.screenshot = true;
+		}
+		else if( e.IsPress() && e.GetCode() == VK_F11 )
+		{
+			model.capturing = !model.capturing;
+		}
+	}
 	while( !mouse.MouseEmpty() )
 	{
 		MouseEvent e = mouse.ReadMouse();
 		if( e.GetType() == MouseEvent::WheelDown )
 		{
-			alpha -= 3;
+			model.alpha -= 3;
 		}
 		else if( e.GetType() == MouseEvent::WheelUp )
 		{
-			alpha += 3;
+			model.alpha += 3;
 		}
 	}
+	model.mousePos = { mouse.GetMouseX(),mouse.GetMouseY() };
 }
 
-void Game::ComposeFrame()
+void Game::ComposeFrame( const Model& model )
 {
-	Vei2 p = { mouse.GetMouseX(),mouse.GetMouseY() };
-	Color c = { alpha,GREEN };
+	PROFILE_FUNCTION();
+	Vei2 p = model.mousePos;
+	Color c = { model.alpha,GREEN };
 
+	ft.StartFrame();
 	gfx.sysBuffer.Copy( bees );
+	ft.StopFrame();
 
-	ft.StartFrame();
-	ft.StopFrame( logFile );
+	CaptureFrame( model );
 }
+
+// runs wherever ComposeFrame does, so sysBuffer is complete and not being written
+void Game::CaptureFrame( const Model& model )
+{
+	if( model.screenshot )
+	{
+		std::wstringstream filename;
+		filename << L"screenshot" << std::setw( 3 ) << std::setfill( L'0' ) << nScreenshots++ << L".qoi";
+		capture.Screenshot( gfx.sysBuffer,filename.str() );
+	}
+	if( model.capturing != capture.IsSequenceActive() )
+	{
+		if( model.capturing )
+		{
+			capture.BeginSequence( L"capture.y4m",FrameCapture::Y4m );
+		}
+		else
+		{
+			capture.EndSequence();
+		}
+	}
+	if( model.capturing )
+	{
+		capture.CaptureFrame( gfx.sysBuffer );
+	}
+}
\ No newline at end of file
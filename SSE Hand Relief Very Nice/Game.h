@@ -25,17 +25,43 @@
 #include "Mouse.h"
 #include "Timer.h"
 #include "FrameTimer.h"
+#include "FramePipeline.h"
+#include "FrameCapture.h"
 #include <fstream>
+#include <thread>
 
 class Game
 {
 public:
-	Game( HWND hWnd,KeyboardServer& kServer,MouseServer& mServer );
+	Game( HWND hWnd,KeyboardServer& kServer,MouseServer& mServer,bool pipelined = false );
 	~Game();
 	void Go();
+	// last composed frame (only meaningful between calls to Go in the default mode)
+	const Surface& GetFrame() const
+	{
+		return gfx.sysBuffer;
+	}
+	// call before the first Go; in pipelined mode the render thread picks it up with
+	// the first frame it receives
+	void SetFrameExport( FrameExport* pExport )
+	{
+		gfx.SetFrameExport( pExport );
+	}
 private:
-	void ComposeFrame();
-	void UpdateModel();
+	// everything ComposeFrame needs from UpdateModel (copied per frame in pipelined mode)
+	struct Model
+	{
+		Vei2 mousePos = { -1,-1 };
+		unsigned char alpha = 127;
+		// F12 takes a screenshot, F11 starts / stops a capture sequence
+		bool screenshot = false;
+		bool capturing = false;
+	};
+private:
+	void ComposeFrame( const Model& model );
+	void UpdateModel( Model& model );
+	void RenderLoop();
+	void CaptureFrame( const Model& model );
 private:
 	D3DGraphics gfx;
 	KeyboardClient kbd;
@@ -44,7 +70,12 @@ private:
 	Surface bees;
 	Surface marle;
 	Surface flare;
-	unsigned char alpha = 127;
+	Model model;
 	std::wofstream logFile;
 	FrameTimer ft;
+	const bool pipelined;
+	FramePipeline< Model > pipeline;
+	std::thread renderThread;
+	FrameCapture capture;
+	unsigned int nScreenshots;
 };
\ No newline at end of file
@@ -0,0 +1,391 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	HdrSurface.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "HdrSurface.h"
+#include "Surface.h"
+#include "Profiler.h"
+#include "Cpuid.h"
+#include <Windows.h>
+#include <immintrin.h>
+#include <math.h>
+#include <assert.h>
+
+namespace
+{
+	union Bits
+	{
+		float f;
+		unsigned int u;
+	};
+
+	// exact, handles denormals, infinities and NaN
+	inline float HalfToFloat( unsigned short h )
+	{
+		const unsigned int shiftedExp = 0x7C00 << 13;
+		Bits o;
+		o.u = ( h & 0x7FFF ) << 13;
+		const unsigned int exp = shiftedExp & o.u;
+		o.u += ( 127 - 15 ) << 23;
+		if( exp == shiftedExp )
+		{
+			o.u += ( 128 - 16 ) << 23;
+		}
+		else if( exp == 0 )
+		{
+			Bits magic;
+			magic.u = 113 << 23;
+			o.u += 1 << 23;
+			o.f -= magic.f;
+		}
+		o.u |= ( h & 0x8000 ) << 16;
+		return o.f;
+	}
+
+	// round to nearest even, same results as _mm_cvtps_ph( x,0 )
+	inline unsigned short FloatToHalf( float x )
+	{
+		Bits f;
+		f.f = x;
+		const unsigned int sign = f.u & 0x80000000u;
+		f.u ^= sign;
+		unsigned int o;
+		if( f.u >= ( 127 + 16 ) << 23 )
+		{
+			// overflow to infinity, NaN stays NaN
+			o = f.u > ( 255u << 23 ) ? 0x7E00 : 0x7C00;
+		}
+		else if( f.u < ( 113 << 23 ) )
+		{
+			// denormal or zero: let the fp adder do the rounding
+			Bits magic;
+			magic.u = ( ( 127 - 15 ) + ( 23 - 10 ) + 1 ) << 23;
+			f.f += magic.f;
+			o = f.u - magic.u;
+		}
+		else
+		{
+			const unsigned int mantOdd = ( f.u >> 13 ) & 1;
+			// rebias the exponent from 127 to 15 (unsigned, shifting a negative int is UB)
+			f.u -= ( 127u - 15u ) << 23;
+			f.u += 0xFFF;
+			f.u += mantOdd;
+			o = f.u >> 13;
+		}
+		return (unsigned short)( o | ( sign >> 16 ) );
+	}
+
+	// texel access policies: one b g r a texel <-> __m128
+	struct Float4
+	{
+		typedef float Type;
+		static __m128 Load( const float* p )
+		{
+			return _mm_loadu_ps( p );
+		}
+		static void Store( float* p,__m128 v )
+		{
+			_mm_storeu_ps( p,v );
+		}
+	};
+	struct Half4F16C
+	{
+		typedef unsigned short Type;
+		static __m128 Load( const unsigned short* p )
+		{
+			return _mm_cvtph_ps( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( p ) ) );
+		}
+		static void Store( unsigned short* p,__m128 v )
+		{
+			_mm_storel_epi64( reinterpret_cast<__m128i*>( p ),_mm_cvtps_ph( v,0 ) );
+		}
+	};
+	struct Half4Scalar
+	{
+		typedef unsigned short Type;
+		static __m128 Load( const unsigned short* p )
+		{
+			return _mm_setr_ps( HalfToFloat( p[0] ),HalfToFloat( p[1] ),HalfToFloat( p[2] ),HalfToFloat( p[3] ) );
+		}
+		static void Store( unsigned short* p,__m128 v )
+		{
+			float f[4];
+			_mm_storeu_ps( f,v );
+			for( int i = 0; i < 4; i++ )
+			{
+				p[i] = FloatToHalf( f[i] );
+			}
+		}
+	};
+
+	// one Color -> b g r a floats in [0,255]
+	inline __m128 Unpack( Color c )
+	{
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_cvtepi32_ps( _mm_unpacklo_epi16(
+			_mm_unpacklo_epi8( _mm_cvtsi32_si128( c ),zero ),zero ) );
+	}
+
+	template< HdrSurface::ToneMap op >
+	__m128 ApplyToneMap( __m128 c );
+	template<>
+	__m128 ApplyToneMap< HdrSurface::Reinhard >( __m128 c )
+	{
+		return _mm_div_ps( c,_mm_add_ps( c,_mm_set1_ps( 1.0f ) ) );
+	}
+	template<>
+	__m128 ApplyToneMap< HdrSurface::Aces >( __m128 c )
+	{
+		// ( c * ( 2.51c + 0.03 ) ) / ( c * ( 2.43c + 0.59 ) + 0.14 )
+		const __m128 num = _mm_mul_ps( c,_mm_add_ps( _mm_mul_ps( c,_mm_set1_ps( 2.51f ) ),_mm_set1_ps( 0.03f ) ) );
+		const __m128 den = _mm_add_ps( _mm_mul_ps( c,_mm_add_ps( _mm_mul_ps( c,_mm_set1_ps( 2.43f ) ),
+			_mm_set1_ps( 0.59f ) ) ),_mm_set1_ps( 0.14f ) );
+		return _mm_div_ps( num,den );
+	}
+	template<>
+	__m128 ApplyToneMap< HdrSurface::Clamp >( __m128 c )
+	{
+		return c;
+	}
+}
+
+HdrSurface::HdrSurface( unsigned int width,unsigned int height,Format format )
+	:
+	width( width ),
+	height( height ),
+	format( format ),
+	useF16C( InstructionSet::F16C() ),
+	halves( nullptr ),
+	floats( nullptr )
+{
+	if( format == RGBA16F )
+	{
+		halves = (unsigned short*)_mm_malloc( width * height * 4 * sizeof( unsigned short ),16 );
+	}
+	else
+	{
+		floats = (float*)_mm_malloc( width * height * 4 * sizeof( float ),16 );
+	}
+	SetGamma( 2.2f );
+	Clear();
+}
+
+HdrSurface::~HdrSurface()
+{
+	_mm_free( halves );
+	_mm_free( floats );
+}
+
+void HdrSurface::Clear()
+{
+	PROFILE_FUNCTION();
+	if( format == RGBA16F )
+	{
+		// +0.0 is all zero bits in both formats
+		memset( halves,0,width * height * 4 * sizeof( unsigned short ) );
+	}
+	else
+	{
+		memset( floats,0,width * height * 4 * sizeof( float ) );
+	}
+}
+
+void HdrSurface::Fill( float r,float g,float b )
+{
+	PROFILE_FUNCTION();
+	const unsigned int nTexels = width * height;
+	if( format == RGBA16F )
+	{
+		const unsigned short texel[4] = { FloatToHalf( b ),FloatToHalf( g ),FloatToHalf( r ),FloatToHalf( 1.0f ) };
+		for( unsigned int i = 0; i < nTexels; i++ )
+		{
+			memcpy( &halves[i * 4],texel,sizeof( texel ) );
+		}
+	}
+	else
+	{
+		const __m128 texel = _mm_setr_ps( b,g,r,1.0f );
+		for( unsigned int i = 0; i < nTexels; i++ )
+		{
+			_mm_store_ps( &floats[i * 4],texel );
+		}
+	}
+}
+
+void HdrSurface::AddLight( const Surface& src,float intensity )
+{
+	AddLight( { 0,0 },RectI( 0,(int)width,0,(int)height ),src,intensity );
+}
+
+void HdrSurface::AddLight( Vei2 dstPt,const RectI& srcRect,const Surface& src,float intensity )
+{
+	PROFILE_FUNCTION();
+	assert( dstPt.x >= 0 && dstPt.x + srcRect.GetWidth() <= (int)width );
+	assert( dstPt.y >= 0 && dstPt.y + srcRect.GetHeight() <= (int)height );
+	if( format == RGBA32F )
+	{
+		AddLightRows< Float4 >( dstPt,srcRect,src,intensity );
+	}
+	else if( useF16C )
+	{
+		AddLightRows< Half4F16C >( dstPt,srcRect,src,intensity );
+	}
+	else
+	{
+		AddLightRows< Half4Scalar >( dstPt,srcRect,src,intensity );
+	}
+}
+
+template< class Texel >
+void HdrSurface::AddLightRows( Vei2 dstPt,const RectI& srcRect,const Surface& src,float intensity )
+{
+	typename Texel::Type* const texels = reinterpret_cast<typename Texel::Type*>(
+		format == RGBA16F ? (void*)halves : (void*)floats );
+	// bytes -> [0,1] for colour and alpha at once
+	const __m128 scale = _mm_set1_ps( intensity / ( 255.0f * 255.0f ) );
+	for( int y = 0; y < srcRect.GetHeight(); y++ )
+	{
+		const Color* pSrc = &src.GetBufferConst()[( srcRect.top + y ) * src.GetPixelPitch() + srcRect.left];
+		typename Texel::Type* pDst = &texels[( ( dstPt.y + y ) * width + dstPt.x ) * 4];
+		for( const Color* end = pSrc + srcRect.GetWidth(); pSrc < end; pSrc++,pDst += 4 )
+		{
+			// fully transparent light pixels are common (sprite borders), skip the texel
+			if( pSrc->x == 0 )
+			{
+				continue;
+			}
+			const __m128 c = Unpack( *pSrc );
+			const __m128 weight = _mm_mul_ps( _mm_shuffle_ps( c,c,_MM_SHUFFLE( 3,3,3,3 ) ),scale );
+			Texel::Store( pDst,_mm_add_ps( Texel::Load( pDst ),_mm_mul_ps( c,weight ) ) );
+		}
+	}
+}
+
+void HdrSurface::Resolve( Surface& dst,ToneMap op,float exposure ) const
+{
+	PROFILE_FUNCTION();
+	assert( dst.GetWidth() == width );
+	assert( dst.GetHeight() == height );
+	if( format == RGBA32F )
+	{
+		ResolveWith< Float4 >( dst,op,exposure );
+	}
+	else if( useF16C )
+	{
+		ResolveWith< Half4F16C >( dst,op,exposure );
+	}
+	else
+	{
+		ResolveWith< Half4Scalar >( dst,op,exposure );
+	}
+}
+
+template< class Texel >
+void HdrSurface::ResolveWith( Surface& dst,ToneMap op,float exposure ) const
+{
+	switch( op )
+	{
+	case Reinhard:
+		ResolveRows< Texel,Reinhard >( dst,exposure );
+		break;
+	case Aces:
+		ResolveRows< Texel,Aces >( dst,exposure );
+		break;
+	default:
+		ResolveRows< Texel,Clamp >( dst,exposure );
+		break;
+	}
+}
+
+template< class Texel,HdrSurface::ToneMap op >
+void HdrSurface::ResolveRows( Surface& dst,float exposure ) const
+{
+	const typename Texel::Type* const texels = reinterpret_cast<const typename Texel::Type*>(
+		format == RGBA16F ? (const void*)halves : (const void*)floats );
+	const __m128 exposure4 = _mm_set1_ps( exposure );
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 tableScale = _mm_set1_ps( float( gammaTableSize - 1 ) );
+	const __m128 half = _mm_set1_ps( 0.5f );
+	Color* const pDstBase = dst.GetBuffer();
+	for( unsigned int y = 0; y < height; y++ )
+	{
+		const typename Texel::Type* pSrc = &texels[y * width * 4];
+		Color* pDst = &pDstBase[y * dst.GetPixelPitch()];
+		Color* const end = pDst + width;
+		// four texels at a time, transposed so the curve runs on b, g and r vectors only
+		for( ; pDst + 4 <= end; pDst += 4,pSrc += 16 )
+		{
+			__m128 b = Texel::Load( pSrc );
+			__m128 g = Texel::Load( pSrc + 4 );
+			__m128 r = Texel::Load( pSrc + 8 );
+			__m128 a = Texel::Load( pSrc + 12 );
+			_MM_TRANSPOSE4_PS( b,g,r,a );
+			int index[3][4];
+			const __m128 channels[3] = { b,g,r };
+			for( int i = 0; i < 3; i++ )
+			{
+				__m128 c = ApplyToneMap< op >( _mm_mul_ps( channels[i],exposure4 ) );
+				// clamping also turns NaN (from inf / inf) into 0
+				c = _mm_min_ps( _mm_max_ps( c,zero ),one );
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( index[i] ),
+					_mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( c,tableScale ),half ) ) );
+			}
+			for( int i = 0; i < 4; i++ )
+			{
+				pDst[i] = Color( 255,gammaTable[index[2][i]],gammaTable[index[1][i]],gammaTable[index[0][i]] );
+			}
+		}
+		for( ; pDst < end; pDst++,pSrc += 4 )
+		{
+			__m128 c = ApplyToneMap< op >( _mm_mul_ps( Texel::Load( pSrc ),exposure4 ) );
+			c = _mm_min_ps( _mm_max_ps( c,zero ),one );
+			int index[4];
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( index ),
+				_mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( c,tableScale ),half ) ) );
+			*pDst = Color( 255,gammaTable[index[2]],gammaTable[index[1]],gammaTable[index[0]] );
+		}
+	}
+}
+
+void HdrSurface::SetGamma( float gamma )
+{
+	assert( gamma > 0.0f );
+	const float invGamma = 1.0f / gamma;
+	for( unsigned int i = 0; i < gammaTableSize; i++ )
+	{
+		const float linear = float( i ) / float( gammaTableSize - 1 );
+		gammaTable[i] = (unsigned char)( powf( linear,invGamma ) * 255.0f + 0.5f );
+	}
+}
+
+unsigned int HdrSurface::GetWidth() const
+{
+	return width;
+}
+
+unsigned int HdrSurface::GetHeight() const
+{
+	return height;
+}
+
+HdrSurface::Format HdrSurface::GetFormat() const
+{
+	return format;
+}
\ No newline at end of file
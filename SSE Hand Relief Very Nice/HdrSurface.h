@@ -0,0 +1,88 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	HdrSurface.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include "Rect.h"
+#include "Colors.h"
+
+class Surface;
+
+// floating point light accumulation buffer: lights are added without clamping and the
+// result is tone mapped and gamma encoded into an 8-bit Surface once per frame
+// texels are b g r a floats (Color's channel order) stored either as halves (8 bytes
+// per pixel, F16C conversion when InstructionSet::F16C() says so) or as full floats
+class HdrSurface
+{
+public:
+	enum Format
+	{
+		RGBA16F,
+		RGBA32F
+	};
+	enum ToneMap
+	{
+		// c / ( 1 + c )
+		Reinhard,
+		// Narkowicz's fitted ACES filmic curve
+		Aces,
+		// clamp to [0,1]
+		Clamp
+	};
+public:
+	HdrSurface( unsigned int width,unsigned int height,Format format = RGBA16F );
+	HdrSurface( const HdrSurface& ) = delete;
+	HdrSurface& operator=( const HdrSurface& ) = delete;
+	~HdrSurface();
+	void Clear();
+	// ambient light, channels in linear units where 1.0 is full 8-bit white
+	void Fill( float r,float g,float b );
+	// dst += src.rgb * src.alpha * intensity (all normalized to [0,1]) over the whole surface
+	void AddLight( const Surface& src,float intensity = 1.0f );
+	// same for srcRect of src with its top left at dstPt (no clipping)
+	void AddLight( Vei2 dstPt,const RectI& srcRect,const Surface& src,float intensity = 1.0f );
+	// scale by exposure, tone map, gamma encode and write opaque pixels into dst
+	// (which must be the same size)
+	void Resolve( Surface& dst,ToneMap op = Aces,float exposure = 1.0f ) const;
+	// rebuilds the encoding table; 2.2 by default
+	void SetGamma( float gamma );
+	unsigned int GetWidth() const;
+	unsigned int GetHeight() const;
+	Format GetFormat() const;
+private:
+	template< class Texel >
+	void AddLightRows( Vei2 dstPt,const RectI& srcRect,const Surface& src,float intensity );
+	template< class Texel,ToneMap op >
+	void ResolveRows( Surface& dst,float exposure ) const;
+	template< class Texel >
+	void ResolveWith( Surface& dst,ToneMap op,float exposure ) const;
+private:
+	static const unsigned int gammaTableSize = 4096;
+	unsigned int width;
+	unsigned int height;
+	Format format;
+	bool useF16C;
+	// one of these is allocated depending on format
+	unsigned short* halves;
+	float* floats;
+	// tone mapped [0,1] -> encoded byte
+	unsigned char gammaTable[gammaTableSize];
+};
\ No newline at end of file
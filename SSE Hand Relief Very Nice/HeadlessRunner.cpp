@@ -0,0 +1,70 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	HeadlessRunner.cpp																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "HeadlessRunner.h"
+#include "Game.h"
+#include "InputRecorder.h"
+#include "Timer.h"
+#include <float.h>
+#include <sstream>
+#include <iomanip>
+
+int RunHeadless( const std::wstring& replayFile,std::wostream& report )
+{
+	KeyboardServer kServ;
+	MouseServer mServ;
+	InputPlayer player( replayFile );
+	if( !player.IsValid() )
+	{
+		report << L"Could not read input recording [" << replayFile << L"]" << std::endl;
+		return 1;
+	}
+
+	Game theGame( NULL,kServ,mServ );
+	Timer timer;
+	float timeSum = 0.0f;
+	float timeMin = FLT_MAX;
+	float timeMax = 0.0f;
+	unsigned long long checksum = 0;
+	while( player.PlayFrame( kServ,mServ ) )
+	{
+		timer.StartWatch();
+		theGame.Go();
+		timer.StopWatch();
+		const float frameTime = timer.GetTimeMilli();
+		timeSum += frameTime;
+		timeMin = min( timeMin,frameTime );
+		timeMax = max( timeMax,frameTime );
+
+		// chain frame hashes so the final value depends on every frame and their order
+		checksum = checksum * 31 + theGame.GetFrame().Checksum();
+	}
+
+	const unsigned int nFrames = player.GetFrameCount();
+	std::wstringstream ss;
+	ss.precision( 3 );
+	ss << L"Frames: [" << nFrames << L"] Total: [" << std::fixed << timeSum
+		<< L"] Avg: [" << ( nFrames > 0 ? timeSum / (float)nFrames : 0.0f )
+		<< L"] Min: [" << ( nFrames > 0 ? timeMin : 0.0f ) << L"] Max: [" << timeMax
+		<< L"] Checksum: [" << std::hex << std::setw( 16 ) << std::setfill( L'0' ) << checksum
+		<< L"]" << std::endl;
+	report << ss.str();
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	HeadlessRunner.h																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include <string>
+#include <ostream>
+
+// replays an input recording (see InputRecorder) against a windowless Game as fast as
+// possible and writes frame timings plus a checksum of every composed frame to report,
+// so identical workloads can be benchmarked and compared across builds
+// returns 0 on success, nonzero if the recording could not be read
+int RunHeadless( const std::wstring& replayFile,std::wostream& report );
\ No newline at end of file
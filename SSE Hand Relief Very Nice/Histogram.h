@@ -0,0 +1,165 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	Histogram.h																			  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// HDR style log-linear histogram of 64-bit integer samples (timer ticks)
+// values below 2^subBits get exact buckets; above that every power of two range is
+// split into 2^subBits linear sub-buckets, so relative error stays under 2^-subBits
+// Record is lock-free and may run concurrently with Snapshot on another thread
+class Histogram
+{
+public:
+	static const unsigned int subBits = 5;
+	static const unsigned int subCount = 1u << subBits;
+	static const unsigned int nBuckets = ( 64 - subBits + 1 ) * subCount;
+public:
+	// plain copy of the counters, safe to crunch on any thread
+	class Snapshot
+	{
+	public:
+		Snapshot()
+			:
+			counts( nBuckets,0 ),
+			total( 0 ),
+			sum( 0 )
+		{}
+		// value at quantile q (0..1), reported as the midpoint of the bucket it falls in
+		unsigned long long Percentile( double q ) const
+		{
+			if( total == 0 )
+			{
+				return 0;
+			}
+			unsigned long long rank = (unsigned long long)( q * (double)total + 0.5 );
+			rank = rank < 1 ? 1 : ( rank > total ? total : rank );
+			unsigned long long seen = 0;
+			for( unsigned int b = 0; b < nBuckets; b++ )
+			{
+				seen += counts[b];
+				if( seen >= rank )
+				{
+					return BucketLow( b ) + BucketWidth( b ) / 2;
+				}
+			}
+			return BucketLow( nBuckets - 1 );
+		}
+		unsigned long long GetTotal() const
+		{
+			return total;
+		}
+		unsigned long long GetSum() const
+		{
+			return sum;
+		}
+		// counts recorded since an earlier snapshot of the same histogram
+		Snapshot operator-( const Snapshot& earlier ) const
+		{
+			Snapshot diff;
+			for( unsigned int b = 0; b < nBuckets; b++ )
+			{
+				diff.counts[b] = counts[b] - earlier.counts[b];
+			}
+			diff.total = total - earlier.total;
+			diff.sum = sum - earlier.sum;
+			return diff;
+		}
+	private:
+		friend class Histogram;
+		std::vector<unsigned long long> counts;
+		unsigned long long total;
+		unsigned long long sum;
+	};
+public:
+	Histogram()
+		:
+		total( 0 ),
+		sum( 0 )
+	{
+		for( unsigned int b = 0; b < nBuckets; b++ )
+		{
+			counts[b] = 0;
+		}
+	}
+	Histogram( const Histogram& ) = delete;
+	Histogram& operator=( const Histogram& ) = delete;
+	void Record( unsigned long long value )
+	{
+		counts[BucketIndex( value )].fetch_add( 1,std::memory_order_relaxed );
+		sum.fetch_add( value,std::memory_order_relaxed );
+		total.fetch_add( 1,std::memory_order_release );
+	}
+	Snapshot Take() const
+	{
+		Snapshot s;
+		s.total = total.load( std::memory_order_acquire );
+		s.sum = sum.load( std::memory_order_relaxed );
+		for( unsigned int b = 0; b < nBuckets; b++ )
+		{
+			s.counts[b] = counts[b].load( std::memory_order_relaxed );
+		}
+		return s;
+	}
+	static unsigned int BucketIndex( unsigned long long value )
+	{
+		if( value < subCount )
+		{
+			return (unsigned int)value;
+		}
+		const unsigned int msb = HighestBit( value );
+		const unsigned int group = msb - subBits + 1;
+		const unsigned int sub = (unsigned int)( value >> ( msb - subBits ) ) - subCount;
+		return group * subCount + sub;
+	}
+	static unsigned long long BucketLow( unsigned int index )
+	{
+		const unsigned int group = index >> subBits;
+		if( group == 0 )
+		{
+			return index;
+		}
+		return (unsigned long long)( subCount + ( index & ( subCount - 1 ) ) ) << ( group - 1 );
+	}
+	static unsigned long long BucketWidth( unsigned int index )
+	{
+		const unsigned int group = index >> subBits;
+		return group == 0 ? 1 : 1ull << ( group - 1 );
+	}
+private:
+	static unsigned int HighestBit( unsigned long long value )
+	{
+		// split in halves so this also works on 32-bit targets
+		const unsigned int hi = (unsigned int)( value >> 32 );
+		unsigned int v = hi != 0 ? hi : (unsigned int)value;
+		unsigned int bit = hi != 0 ? 32 : 0;
+		while( v >>= 1 )
+		{
+			bit++;
+		}
+		return bit;
+	}
+private:
+	std::atomic<unsigned long long> counts[nBuckets];
+	std::atomic<unsigned long long> total;
+	std::atomic<unsigned long long> sum;
+};
\ No newline at end of file
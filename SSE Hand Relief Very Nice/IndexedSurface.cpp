@@ -0,0 +1,161 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	IndexedSurface.cpp																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "IndexedSurface.h"
+#include "Cpuid.h"
+#include <Windows.h>
+#include <climits>
+#include <unordered_map>
+
+IndexedSurface::IndexedSurface( unsigned int width,unsigned int height )
+	:
+	PixelSurface( width,height ),
+	paletteSize( 256 ),
+	useAvx2( InstructionSet::AVX2() )
+{
+	memset( palette,0,sizeof( palette ) );
+}
+
+IndexedSurface::IndexedSurface( const Surface& src )
+	:
+	IndexedSurface( src.GetWidth(),src.GetHeight() )
+{
+	std::unordered_map< D3DCOLOR,unsigned char > indices;
+	paletteSize = 0;
+	for( unsigned int y = 0; y < height; y++ )
+	{
+		const Color* const pSrc = &src.GetBufferConst()[y * src.GetPixelPitch()];
+		unsigned char* const pDst = &buffer[y * pixelPitch];
+		for( unsigned int x = 0; x < width; x++ )
+		{
+			const Color c = pSrc[x];
+			const auto i = indices.find( c );
+			if( i != indices.end() )
+			{
+				pDst[x] = i->second;
+			}
+			else if( paletteSize < 256 )
+			{
+				palette[paletteSize] = c;
+				indices.emplace( c,(unsigned char)paletteSize );
+				pDst[x] = (unsigned char)paletteSize++;
+			}
+			else
+			{
+				// palette full: nearest entry by squared ARGB distance
+				unsigned int bestIndex = 0;
+				int bestDist = INT_MAX;
+				for( unsigned int j = 0; j < 256; j++ )
+				{
+					const int da = palette[j].x - c.x;
+					const int dr = palette[j].r - c.r;
+					const int dg = palette[j].g - c.g;
+					const int db = palette[j].b - c.b;
+					const int dist = da * da + dr * dr + dg * dg + db * db;
+					if( dist < bestDist )
+					{
+						bestDist = dist;
+						bestIndex = j;
+					}
+				}
+				indices.emplace( c,(unsigned char)bestIndex );
+				pDst[x] = (unsigned char)bestIndex;
+			}
+		}
+	}
+}
+
+void IndexedSurface::SetPaletteEntry( unsigned char index,Color c )
+{
+	palette[index] = c;
+}
+
+Color IndexedSurface::GetPaletteEntry( unsigned char index ) const
+{
+	return palette[index];
+}
+
+void IndexedSurface::SetPalette( const Color* colors,unsigned int first,unsigned int count )
+{
+	assert( first + count <= 256 );
+	memcpy( &palette[first],colors,count * sizeof( Color ) );
+}
+
+const Color* IndexedSurface::GetPalette() const
+{
+	return palette;
+}
+
+unsigned int IndexedSurface::GetPaletteSize() const
+{
+	return paletteSize;
+}
+
+void IndexedSurface::CyclePalette( unsigned int first,unsigned int count,int steps )
+{
+	assert( first + count <= 256 );
+	if( count < 2 )
+	{
+		return;
+	}
+	// rotating right by steps == rotating left by count - steps
+	const unsigned int shift = (unsigned int)( ( steps % (int)count + (int)count ) % (int)count );
+	std::rotate( &palette[first],&palette[first + count - shift],&palette[first + count] );
+}
+
+void IndexedSurface::Blt( Vei2 dstPt,const RectI& srcRect,Surface& dst ) const
+{
+	PROFILE_FUNCTION();
+	Expand( dstPt,srcRect,dst,-1 );
+}
+
+void IndexedSurface::BltKey( Vei2 dstPt,const RectI& srcRect,Surface& dst,unsigned char keyIndex ) const
+{
+	PROFILE_FUNCTION();
+	Expand( dstPt,srcRect,dst,keyIndex );
+}
+
+void IndexedSurface::ConvertTo( Surface& dst ) const
+{
+	assert( dst.GetWidth() == width );
+	assert( dst.GetHeight() == height );
+	Blt( { 0,0 },RectI( 0,(int)width,0,(int)height ),dst );
+}
+
+void IndexedSurface::Expand( Vei2 dstPt,const RectI& srcRect,Surface& dst,int key ) const
+{
+	assert( dstPt.x >= 0 && dstPt.x + srcRect.GetWidth() <= (int)dst.GetWidth() );
+	assert( dstPt.y >= 0 && dstPt.y + srcRect.GetHeight() <= (int)dst.GetHeight() );
+	Color* const pDst = dst.GetBuffer();
+	const unsigned int dstPitch = dst.GetPixelPitch();
+	for( int y = 0; y < srcRect.GetHeight(); y++ )
+	{
+		Color* const pRow = &pDst[( dstPt.y + y ) * dstPitch + dstPt.x];
+		const unsigned char* const pIndices = &buffer[( srcRect.top + y ) * pixelPitch + srcRect.left];
+		if( useAvx2 )
+		{
+			PixelFormat::Expand< Pixel::AVX2 >::Run( pRow,pIndices,srcRect.GetWidth(),palette,key );
+		}
+		else
+		{
+			PixelFormat::Expand< Pixel::Scalar >::Run( pRow,pIndices,srcRect.GetWidth(),palette,key );
+		}
+	}
+}
\ No newline at end of file
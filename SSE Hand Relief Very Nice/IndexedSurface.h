@@ -0,0 +1,55 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	IndexedSurface.h																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "PixelSurface.h"
+
+// 8-bit palettized surface: one byte per pixel plus a 256 entry Color palette
+// palette swaps and cycling only touch the palette, so recolouring costs nothing per
+// pixel; pixels are expanded to ARGB when blitted (AVX2 gather when available)
+class IndexedSurface : public PixelSurface< PixelFormat::I8 >
+{
+public:
+	IndexedSurface( unsigned int width,unsigned int height );
+	// builds the palette from src's distinct colours; past 256 colours the remaining
+	// ones map to the nearest palette entry
+	explicit IndexedSurface( const Surface& src );
+	void SetPaletteEntry( unsigned char index,Color c );
+	Color GetPaletteEntry( unsigned char index ) const;
+	// copies count colours into the palette starting at entry first
+	void SetPalette( const Color* colors,unsigned int first = 0,unsigned int count = 256 );
+	const Color* GetPalette() const;
+	unsigned int GetPaletteSize() const;
+	// rotates entries [first,first + count) by steps (positive moves colours to higher indices)
+	void CyclePalette( unsigned int first,unsigned int count,int steps );
+	// expands srcRect with its top left at dstPt (no clipping)
+	void Blt( Vei2 dstPt,const RectI& srcRect,Surface& dst ) const;
+	// same, but pixels holding keyIndex are left transparent
+	void BltKey( Vei2 dstPt,const RectI& srcRect,Surface& dst,unsigned char keyIndex ) const;
+	void ConvertTo( Surface& dst ) const;
+private:
+	void Expand( Vei2 dstPt,const RectI& srcRect,Surface& dst,int key ) const;
+private:
+	Color palette[256];
+	// entries actually in use after construction from a Surface
+	unsigned int paletteSize;
+	bool useAvx2;
+};
\ No newline at end of file
@@ -0,0 +1,185 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	InputRecorder.cpp																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "InputRecorder.h"
+#include <Windows.h>
+
+InputRecorder::InputRecorder( const std::wstring& filename )
+	:
+	file( filename.c_str(),std::ios::binary )
+{
+	unsigned long long frequency;
+	QueryPerformanceFrequency( (LARGE_INTEGER*)&frequency );
+	QueryPerformanceCounter( (LARGE_INTEGER*)&lastFrameCount );
+
+	file.write( "CHIR",4 );
+	Write( InputRecord::version );
+	Write( frequency );
+}
+
+void InputRecorder::OnFrame()
+{
+	unsigned long long count;
+	QueryPerformanceCounter( (LARGE_INTEGER*)&count );
+	Write( InputRecord::Frame );
+	Write( (unsigned int)( count - lastFrameCount ) );
+	lastFrameCount = count;
+}
+
+void InputRecorder::OnKey( KeyEvent::EventType type,unsigned char keycode )
+{
+	Write( type == KeyEvent::Press ? InputRecord::KeyPress : InputRecord::KeyRelease );
+	Write( keycode );
+}
+
+void InputRecorder::OnChar( unsigned char character )
+{
+	Write( InputRecord::Char );
+	Write( character );
+}
+
+void InputRecorder::OnMouse( MouseEvent::Type type,int x,int y )
+{
+	Write( (unsigned char)( InputRecord::MouseBase + type ) );
+	Write( (short)x );
+	Write( (short)y );
+}
+
+void InputRecorder::OnMouseEnter()
+{
+	Write( InputRecord::MouseEnter );
+}
+
+void InputRecorder::OnMouseLeave()
+{
+	Write( InputRecord::MouseLeave );
+}
+
+InputPlayer::InputPlayer( const std::wstring& filename )
+	:
+	file( filename.c_str(),std::ios::binary ),
+	valid( false ),
+	invFreqMilli( 0.0f ),
+	frameTicks( 0 ),
+	frameCount( 0 )
+{
+	char magic[4];
+	unsigned short version;
+	unsigned long long frequency;
+	if( file.read( magic,4 ) && memcmp( magic,"CHIR",4 ) == 0 &&
+		Read( version ) && version == InputRecord::version &&
+		Read( frequency ) && frequency != 0 )
+	{
+		invFreqMilli = 1.0f / (float)( (double)frequency / 1000.0 );
+		valid = true;
+	}
+}
+
+bool InputPlayer::IsValid() const
+{
+	return valid;
+}
+
+bool InputPlayer::PlayFrame( KeyboardServer& kServer,MouseServer& mServer )
+{
+	if( !valid )
+	{
+		return false;
+	}
+	unsigned char kind;
+	while( Read( kind ) )
+	{
+		unsigned char code;
+		short x;
+		short y;
+		switch( kind )
+		{
+		case InputRecord::Frame:
+			if( !Read( frameTicks ) )
+			{
+				return false;
+			}
+			frameCount++;
+			return true;
+		case InputRecord::KeyPress:
+			Read( code );
+			kServer.OnKeyPressed( code );
+			break;
+		case InputRecord::KeyRelease:
+			Read( code );
+			kServer.OnKeyReleased( code );
+			break;
+		case InputRecord::Char:
+			Read( code );
+			kServer.OnChar( code );
+			break;
+		case InputRecord::MouseEnter:
+			mServer.OnMouseEnter();
+			break;
+		case InputRecord::MouseLeave:
+			mServer.OnMouseLeave();
+			break;
+		default:
+			Read( x );
+			Read( y );
+			switch( kind - InputRecord::MouseBase )
+			{
+			case MouseEvent::Move:
+				mServer.OnMouseMove( x,y );
+				break;
+			case MouseEvent::LPress:
+				mServer.OnLeftPressed( x,y );
+				break;
+			case MouseEvent::LRelease:
+				mServer.OnLeftReleased( x,y );
+				break;
+			case MouseEvent::RPress:
+				mServer.OnRightPressed( x,y );
+				break;
+			case MouseEvent::RRelease:
+				mServer.OnRightReleased( x,y );
+				break;
+			case MouseEvent::WheelUp:
+				mServer.OnWheelUp( x,y );
+				break;
+			case MouseEvent::WheelDown:
+				mServer.OnWheelDown( x,y );
+				break;
+			default:
+				// corrupt record, nothing after this can be trusted
+				valid = false;
+				return false;
+			}
+			break;
+		}
+	}
+	// events after the last frame marker never reached a frame
+	return false;
+}
+
+float InputPlayer::GetFrameTimeMilli() const
+{
+	return (float)frameTicks * invFreqMilli;
+}
+
+unsigned int InputPlayer::GetFrameCount() const
+{
+	return frameCount;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	InputRecorder.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Keyboard.h"
+#include "Mouse.h"
+#include <fstream>
+#include <string>
+
+// input recording file layout (little endian):
+//   header: 'C' 'H' 'I' 'R', uint16 version, uint64 tick frequency
+//   records: uint8 kind followed by a kind-specific payload
+//     Frame:      uint32 ticks since previous frame marker
+//     Key*:       uint8 keycode
+//     Char:       uint8 character
+//     Mouse*:     int16 x, int16 y
+//     Enter/Leave: nothing
+// events belong to the frame whose marker follows them
+namespace InputRecord
+{
+	enum Kind : unsigned char
+	{
+		Frame,
+		KeyPress,
+		KeyRelease,
+		Char,
+		MouseEnter,
+		MouseLeave,
+		// MouseEvent::Type values are stored offset by MouseBase
+		MouseBase
+	};
+	const unsigned short version = 1;
+}
+
+// captures everything the servers receive; hook it up with
+// KeyboardServer::SetRecorder / MouseServer::SetRecorder
+class InputRecorder
+{
+public:
+	InputRecorder( const std::wstring& filename );
+	InputRecorder( const InputRecorder& ) = delete;
+	InputRecorder& operator=( const InputRecorder& ) = delete;
+	// call once per frame after the frame's input has been dispatched
+	void OnFrame();
+	void OnKey( KeyEvent::EventType type,unsigned char keycode );
+	void OnChar( unsigned char character );
+	void OnMouse( MouseEvent::Type type,int x,int y );
+	void OnMouseEnter();
+	void OnMouseLeave();
+private:
+	template< typename T >
+	void Write( T val )
+	{
+		file.write( reinterpret_cast<const char*>( &val ),sizeof( val ) );
+	}
+private:
+	std::ofstream file;
+	unsigned long long lastFrameCount;
+};
+
+// feeds a recording back into a pair of servers one frame at a time
+class InputPlayer
+{
+public:
+	InputPlayer( const std::wstring& filename );
+	InputPlayer( const InputPlayer& ) = delete;
+	InputPlayer& operator=( const InputPlayer& ) = delete;
+	bool IsValid() const;
+	// dispatch the events of the next recorded frame; false when the recording is exhausted
+	bool PlayFrame( KeyboardServer& kServer,MouseServer& mServer );
+	// recorded wall time of the last played frame in milliseconds
+	float GetFrameTimeMilli() const;
+	unsigned int GetFrameCount() const;
+private:
+	template< typename T >
+	bool Read( T& val )
+	{
+		return bool( file.read( reinterpret_cast<char*>( &val ),sizeof( val ) ) );
+	}
+private:
+	std::ifstream file;
+	bool valid;
+	float invFreqMilli;
+	unsigned int frameTicks;
+	unsigned int frameCount;
+};
\ No newline at end of file
@@ -19,6 +19,7 @@
  *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
  ******************************************************************************************/
 #include "Keyboard.h"
+#include "InputRecorder.h"
 
 KeyboardClient::KeyboardClient( KeyboardServer& kServer )
 	: server( kServer )
@@ -31,10 +32,9 @@ bool KeyboardClient::KeyIsPressed( unsigned char keycode ) const
 
 KeyEvent KeyboardClient::ReadKey()
 {
-	if( server.keybuffer.size() > 0 )
+	KeyEvent e;
+	if( server.keybuffer.Pop( e ) )
 	{
-		KeyEvent e = server.keybuffer.front();
-		server.keybuffer.pop();
 		return e;
 	}
 	else
@@ -45,9 +45,10 @@ KeyEvent KeyboardClient::ReadKey()
 
 KeyEvent KeyboardClient::PeekKey() const
 {	
-	if( server.keybuffer.size() > 0 )
+	KeyEvent e;
+	if( server.keybuffer.Peek( e ) )
 	{
-		return server.keybuffer.front();
+		return e;
 	}
 	else
 	{
@@ -57,15 +58,14 @@ KeyEvent KeyboardClient::PeekKey() const
 
 bool KeyboardClient::KeyEmpty() const
 {
-	return server.keybuffer.empty();
+	return server.keybuffer.Empty();
 }
 
 unsigned char KeyboardClient::ReadChar()
 {
-	if( server.charbuffer.size() > 0 )
+	unsigned char charcode;
+	if( server.charbuffer.Pop( charcode ) )
 	{
-		unsigned char charcode = server.charbuffer.front();
-		server.charbuffer.pop();
 		return charcode;
 	}
 	else
@@ -76,9 +76,10 @@ unsigned char KeyboardClient::ReadChar()
 
 unsigned char KeyboardClient::PeekChar() const
 {
-	if( server.charbuffer.size() > 0 )
+	unsigned char charcode;
+	if( server.charbuffer.Peek( charcode ) )
 	{
-		return server.charbuffer.front();
+		return charcode;
 	}
 	else
 	{
@@ -88,23 +89,17 @@ unsigned char KeyboardClient::PeekChar() const
 
 bool KeyboardClient::CharEmpty() const
 {
-	return server.charbuffer.empty();
+	return server.charbuffer.Empty();
 }
 
 void KeyboardClient::FlushKeyBuffer()
 {
-	while( !server.keybuffer.empty() )
-	{
-		server.keybuffer.pop();
-	}
+	server.keybuffer.Clear();
 }
 
 void KeyboardClient::FlushCharBuffer()
 {
-	while( !server.charbuffer.empty() )
-	{
-		server.charbuffer.pop();
-	}
+	server.charbuffer.Clear();
 }
 
 void KeyboardClient::FlushBuffers()
@@ -114,6 +109,8 @@ void KeyboardClient::FlushBuffers()
 }
 
 KeyboardServer::KeyboardServer()
+	:
+	pRecorder( nullptr )
 {
 	for( int x = 0; x < nKeys; x++ )
 	{
@@ -125,29 +122,33 @@ void KeyboardServer::OnKeyPressed( unsigned char keycode )
 {
 	keystates[ keycode ] = true;
 	
-	keybuffer.push( KeyEvent( KeyEvent::Press,keycode ) );
-	if( keybuffer.size() > bufferSize )
+	keybuffer.Push( KeyEvent( KeyEvent::Press,keycode ) );
+	if( pRecorder )
 	{
-		keybuffer.pop();
+		pRecorder->OnKey( KeyEvent::Press,keycode );
 	}
 }
 
 void KeyboardServer::OnKeyReleased( unsigned char keycode )
 {
 	keystates[ keycode ] = false;
-	keybuffer.push( KeyEvent( KeyEvent::Release,keycode ) );
-	if( keybuffer.size() > bufferSize )
+	keybuffer.Push( KeyEvent( KeyEvent::Release,keycode ) );
+	if( pRecorder )
 	{
-		keybuffer.pop();
+		pRecorder->OnKey( KeyEvent::Release,keycode );
 	}
 }
 
 void KeyboardServer::OnChar( unsigned char character )
 {
-	charbuffer.push( character );
-	if( charbuffer.size() > bufferSize )
+	charbuffer.Push( character );
+	if( pRecorder )
 	{
-		charbuffer.pop();
+		pRecorder->OnChar( character );
 	}
 }
 
+void KeyboardServer::SetRecorder( InputRecorder* pRecorder )
+{
+	this->pRecorder = pRecorder;
+}
\ No newline at end of file
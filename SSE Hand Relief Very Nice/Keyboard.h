@@ -20,7 +20,8 @@
  ******************************************************************************************/
 #pragma once
 #include <Windows.h>
-#include <queue>
+#include <atomic>
+#include "SpscRingBuffer.h"
 
 class KeyEvent
 {
@@ -35,6 +36,11 @@ private:
 	EventType type;
 	unsigned char code;
 public:
+	KeyEvent()
+		:
+	type( Invalid ),
+	code( 0 )
+	{}
 	KeyEvent( EventType type,unsigned char code )
 		:
 	type( type ),
@@ -59,6 +65,7 @@ public:
 };
 
 class KeyboardServer;
+class InputRecorder;
 
 class KeyboardClient
 {
@@ -86,10 +93,13 @@ public:
 	void OnKeyPressed( unsigned char keycode );
 	void OnKeyReleased( unsigned char keycode );
 	void OnChar( unsigned char character );
+	// pass nullptr to stop recording
+	void SetRecorder( InputRecorder* pRecorder );
 private:
 	static const int nKeys = 256;
 	static const int bufferSize = 4;
-	bool keystates[ nKeys ];
-	std::queue<KeyEvent> keybuffer;
-	std::queue<unsigned char> charbuffer;
+	std::atomic<bool> keystates[ nKeys ];
+	SpscRingBuffer<KeyEvent,bufferSize> keybuffer;
+	SpscRingBuffer<unsigned char,bufferSize> charbuffer;
+	InputRecorder* pRecorder;
 };
\ No newline at end of file
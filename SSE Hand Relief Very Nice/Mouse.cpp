@@ -19,6 +19,7 @@
  *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
  ******************************************************************************************/
 #include "Mouse.h"
+#include "InputRecorder.h"
 
 MouseClient::MouseClient( MouseServer& server )
 : server( server )
@@ -45,10 +46,9 @@ bool MouseClient::IsInWindow() const
 }
 MouseEvent MouseClient::ReadMouse()
 {
-	if( server.buffer.size() > 0 )
+	MouseEvent e;
+	if( server.buffer.Pop( e ) )
 	{
-		MouseEvent e = server.buffer.front( );
-		server.buffer.pop( );
 		return e;
 	}
 	else
@@ -58,7 +58,7 @@ MouseEvent MouseClient::ReadMouse()
 }
 bool MouseClient::MouseEmpty( ) const
 {
-	return server.buffer.empty( );
+	return server.buffer.Empty( );
 }
 
 
@@ -67,86 +67,79 @@ MouseServer::MouseServer()
 	leftIsPressed( false ),
 	rightIsPressed( false ),
 	x( -1 ),
-	y( -1 )
+	y( -1 ),
+	pRecorder( nullptr )
 {}
 void MouseServer::OnMouseMove( int x,int y )
 {
 	this->x = x;
 	this->y = y;
 
-	buffer.push( MouseEvent( MouseEvent::Move,x,y ) );
-	if( buffer.size( ) > bufferSize )
-	{
-		buffer.pop( );
-	}
+	PushEvent( MouseEvent::Move,x,y );
 }
 void MouseServer::OnMouseLeave()
 {
 	isInWindow = false;
+	if( pRecorder )
+	{
+		pRecorder->OnMouseLeave();
+	}
 }
 void MouseServer::OnMouseEnter()
 {
 	isInWindow = true;
+	if( pRecorder )
+	{
+		pRecorder->OnMouseEnter();
+	}
 }
 void MouseServer::OnLeftPressed( int x,int y )
 {
 	leftIsPressed = true;
 
-	buffer.push( MouseEvent( MouseEvent::LPress,x,y ) );
-	if( buffer.size( ) > bufferSize )
-	{
-		buffer.pop( );
-	}
+	PushEvent( MouseEvent::LPress,x,y );
 }
 void MouseServer::OnLeftReleased( int x,int y )
 {
 	leftIsPressed = false;
 
-	buffer.push( MouseEvent( MouseEvent::LRelease,x,y ) );
-	if( buffer.size( ) > bufferSize )
-	{
-		buffer.pop( );
-	}
+	PushEvent( MouseEvent::LRelease,x,y );
 }
 void MouseServer::OnRightPressed( int x,int y )
 {
 	rightIsPressed = true;
 
-	buffer.push( MouseEvent( MouseEvent::RPress,x,y ) );
-	if( buffer.size( ) > bufferSize )
-	{
-		buffer.pop( );
-	}
+	PushEvent( MouseEvent::RPress,x,y );
 }
 void MouseServer::OnRightReleased( int x,int y )
 {
 	rightIsPressed = false;
 
-	buffer.push( MouseEvent( MouseEvent::RRelease,x,y ) );
-	if( buffer.size( ) > bufferSize )
-	{
-		buffer.pop( );
-	}
+	PushEvent( MouseEvent::RRelease,x,y );
 }
 void MouseServer::OnWheelUp( int x,int y )
 {
-	buffer.push( MouseEvent( MouseEvent::WheelUp,x,y ) );
-	if( buffer.size( ) > bufferSize )
-	{
-		buffer.pop( );
-	}
+	PushEvent( MouseEvent::WheelUp,x,y );
 
 }
 void MouseServer::OnWheelDown( int x,int y )
 {
-	buffer.push( MouseEvent( MouseEvent::WheelDown,x,y ) );
-	if( buffer.size( ) > bufferSize )
-	{
-		buffer.pop( );
-	}
+	PushEvent( MouseEvent::WheelDown,x,y );
 
 }
 bool MouseServer::IsInWindow() const
 {
 	return isInWindow;
+}
+void MouseServer::SetRecorder( InputRecorder* pRecorder )
+{
+	this->pRecorder = pRecorder;
+}
+void MouseServer::PushEvent( MouseEvent::Type type,int x,int y )
+{
+	buffer.Push( MouseEvent( type,x,y ) );
+	if( pRecorder )
+	{
+		pRecorder->OnMouse( type,x,y );
+	}
 }
\ No newline at end of file
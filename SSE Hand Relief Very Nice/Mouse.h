@@ -19,9 +19,11 @@
  *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
  ******************************************************************************************/
 #pragma once
-#include <queue>
+#include <atomic>
+#include "SpscRingBuffer.h"
 
 class MouseServer;
+class InputRecorder;
 
 class MouseEvent
 {
@@ -38,10 +40,16 @@ public:
 		Invalid
 	};
 private:
-	const Type type;
-	const int x;
-	const int y;
+	Type type;
+	int x;
+	int y;
 public:
+	MouseEvent()
+		:
+		type( Invalid ),
+		x( 0 ),
+		y( 0 )
+	{}
 	MouseEvent( Type type,int x,int y )
 		:
 		type( type ),
@@ -96,12 +104,17 @@ public:
 	void OnWheelUp( int x,int y );
 	void OnWheelDown( int x,int y );
 	bool IsInWindow() const;
+	// pass nullptr to stop recording
+	void SetRecorder( InputRecorder* pRecorder );
 private:
-	int x;
-	int y;
-	bool leftIsPressed;
-	bool rightIsPressed;
-	bool isInWindow;
+	void PushEvent( MouseEvent::Type type,int x,int y );
+private:
+	std::atomic<int> x;
+	std::atomic<int> y;
+	std::atomic<bool> leftIsPressed;
+	std::atomic<bool> rightIsPressed;
+	std::atomic<bool> isInWindow;
 	static const int bufferSize = 4;
-	std::queue< MouseEvent > buffer;
+	SpscRingBuffer< MouseEvent,bufferSize > buffer;
+	InputRecorder* pRecorder;
 };
\ No newline at end of file
@@ -0,0 +1,243 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	ParticleSystem.cpp																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "ParticleSystem.h"
+#include "Surface.h"
+#include "Timer.h"
+#include "Profiler.h"
+#include <random>
+#include <string.h>
+#include <emmintrin.h>
+
+namespace
+{
+	float* AllocateStream( unsigned int size )
+	{
+		float* const p = (float*)_mm_malloc( size * sizeof( float ),16 );
+		memset( p,0,size * sizeof( float ) );
+		return p;
+	}
+}
+
+ParticleSystem::ParticleSystem( unsigned int capacity )
+	:
+	capacity( capacity ),
+	count( 0 )
+{
+	const unsigned int paddedCapacity = ( capacity + 3 ) & ~3u;
+	posX = AllocateStream( paddedCapacity );
+	posY = AllocateStream( paddedCapacity );
+	velX = AllocateStream( paddedCapacity );
+	velY = AllocateStream( paddedCapacity );
+	life = AllocateStream( paddedCapacity );
+	color = new Color[paddedCapacity];
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	_mm_free( posX );
+	_mm_free( posY );
+	_mm_free( velX );
+	_mm_free( velY );
+	_mm_free( life );
+	delete[] color;
+}
+
+bool ParticleSystem::Emit( Vec2 pos,Vec2 vel,float lifetime,Color c )
+{
+	if( count == capacity )
+	{
+		return false;
+	}
+	posX[count] = pos.x;
+	posY[count] = pos.y;
+	velX[count] = vel.x;
+	velY[count] = vel.y;
+	life[count] = lifetime;
+	color[count] = c;
+	count++;
+	return true;
+}
+
+void ParticleSystem::Update( float dt,Vec2 accel )
+{
+	PROFILE_FUNCTION();
+	const __m128 dt4 = _mm_set1_ps( dt );
+	const __m128 dvx = _mm_set1_ps( accel.x * dt );
+	const __m128 dvy = _mm_set1_ps( accel.y * dt );
+	const __m128 zero = _mm_setzero_ps();
+	// the last group may run over a few padding slots, which is harmless for the integration,
+	// but their life is 0 so they are masked out of the expiry test
+	const int lastMask = ( count & 3 ) != 0 ? ( 1 << ( count & 3 ) ) - 1 : 0xF;
+	int anyDead = 0;
+	for( unsigned int i = 0; i < count; i += 4 )
+	{
+		// semi-implicit Euler: velocity first, then position with the new velocity
+		const __m128 vx = _mm_add_ps( _mm_load_ps( velX + i ),dvx );
+		const __m128 vy = _mm_add_ps( _mm_load_ps( velY + i ),dvy );
+		_mm_store_ps( velX + i,vx );
+		_mm_store_ps( velY + i,vy );
+		_mm_store_ps( posX + i,_mm_add_ps( _mm_load_ps( posX + i ),_mm_mul_ps( vx,dt4 ) ) );
+		_mm_store_ps( posY + i,_mm_add_ps( _mm_load_ps( posY + i ),_mm_mul_ps( vy,dt4 ) ) );
+		const __m128 l = _mm_sub_ps( _mm_load_ps( life + i ),dt4 );
+		_mm_store_ps( life + i,l );
+		anyDead |= _mm_movemask_ps( _mm_cmple_ps( l,zero ) ) & ( count - i >= 4 ? 0xF : lastMask );
+	}
+
+	// compaction is skipped outright on frames where nothing expired
+	if( anyDead != 0 )
+	{
+		for( unsigned int i = 0; i < count; )
+		{
+			if( life[i] <= 0.0f )
+			{
+				Kill( i );
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+}
+
+void ParticleSystem::Draw( Surface& target,const Surface& atlas,const RectI& sprite ) const
+{
+	PROFILE_FUNCTION();
+	const int spriteWidth = sprite.GetWidth();
+	const int spriteHeight = sprite.GetHeight();
+	const int targetWidth = (int)target.GetWidth();
+	const int targetHeight = (int)target.GetHeight();
+	for( unsigned int i = 0; i < count; i++ )
+	{
+		// clip the sprite against the target
+		const int left = (int)floorf( posX[i] ) - spriteWidth / 2;
+		const int top = (int)floorf( posY[i] ) - spriteHeight / 2;
+		const RectI srcRect(
+			sprite.left + max( -left,0 ),
+			sprite.right - max( left + spriteWidth - targetWidth,0 ),
+			sprite.top + max( -top,0 ),
+			sprite.bottom - max( top + spriteHeight - targetHeight,0 ) );
+		if( srcRect.GetWidth() <= 0 || srcRect.GetHeight() <= 0 )
+		{
+			continue;
+		}
+		const Vei2 dstPt = { max( left,0 ),max( top,0 ) };
+
+		const float fade = min( life[i],1.0f );
+		const Color c = color[i];
+		const Color tint( c.x,(unsigned char)( c.r * fade ),(unsigned char)( c.g * fade ),
+			(unsigned char)( c.b * fade ) );
+		target.Compose< Pixel::Modulated< Pixel::Additive > >( dstPt,srcRect,atlas,
+			Pixel::Modulated< Pixel::Additive >( tint ) );
+	}
+}
+
+void ParticleSystem::Clear()
+{
+	count = 0;
+}
+
+unsigned int ParticleSystem::GetCount() const
+{
+	return count;
+}
+
+unsigned int ParticleSystem::GetCapacity() const
+{
+	return capacity;
+}
+
+void ParticleSystem::Kill( unsigned int i )
+{
+	count--;
+	posX[i] = posX[count];
+	posY[i] = posY[count];
+	velX[i] = velX[count];
+	velY[i] = velY[count];
+	life[i] = life[count];
+	color[i] = color[count];
+}
+
+void ParticleSystem::Benchmark( std::wostream& report )
+{
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	const int nFrames = 10;
+	Surface target( width,height );
+
+	// synthetic 16x16 radial flare so the benchmark doesn't need GDI+
+	const int spriteSize = 16;
+	Surface atlas( spriteSize,spriteSize );
+	for( int y = 0; y < spriteSize; y++ )
+	{
+		for( int x = 0; x < spriteSize; x++ )
+		{
+			const float dx = ( (float)x + 0.5f ) / (float)( spriteSize / 2 ) - 1.0f;
+			const float dy = ( (float)y + 0.5f ) / (float)( spriteSize / 2 ) - 1.0f;
+			const float falloff = max( 1.0f - sqrt( dx * dx + dy * dy ),0.0f );
+			const unsigned char v = (unsigned char)( falloff * falloff * 255.0f );
+			atlas.PutPixel( x,y,Color( v,v,v,v ) );
+		}
+	}
+	const RectI sprite( 0,spriteSize,0,spriteSize );
+
+	std::mt19937 rng( 0 );
+	std::uniform_real_distribution<float> xDist( 0.0f,(float)width );
+	std::uniform_real_distribution<float> yDist( 0.0f,(float)height );
+	std::uniform_real_distribution<float> vDist( -100.0f,100.0f );
+	// long lives so the population stays put for the whole run
+	std::uniform_real_distribution<float> lifeDist( 10.0f,20.0f );
+
+	report.precision( 3 );
+	report << std::fixed;
+	report << L"Particles    Update (ms)    Draw (ms)    Update (ns/p)    Draw (ns/p)" << std::endl;
+	for( unsigned int n = 1000; n <= 1024000; n *= 4 )
+	{
+		ParticleSystem ps( n );
+		for( unsigned int i = 0; i < n; i++ )
+		{
+			ps.Emit( { xDist( rng ),yDist( rng ) },{ vDist( rng ),vDist( rng ) },lifeDist( rng ),
+				Color( 255,255,160,64 ) );
+		}
+
+		Timer timer;
+		unsigned long long updateTicks = 0;
+		unsigned long long drawTicks = 0;
+		for( int frame = 0; frame < nFrames; frame++ )
+		{
+			target.ClearSSE();
+			timer.StartWatch();
+			ps.Update( 1.0f / 60.0f,{ 0.0f,98.0f } );
+			timer.StopWatch();
+			updateTicks += timer.GetTicks();
+			timer.StartWatch();
+			ps.Draw( target,atlas,sprite );
+			timer.StopWatch();
+			drawTicks += timer.GetTicks();
+		}
+
+		const double milliPerTick = 1000.0 / (double)timer.GetFrequency();
+		const double updateMilli = (double)updateTicks * milliPerTick / nFrames;
+		const double drawMilli = (double)drawTicks * milliPerTick / nFrames;
+		report << n << L"    " << updateMilli << L"    " << drawMilli << L"    "
+			<< updateMilli * 1e6 / n << L"    " << drawMilli * 1e6 / n << std::endl;
+	}
+}
\ No newline at end of file
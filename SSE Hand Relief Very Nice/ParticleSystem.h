@@ -0,0 +1,64 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	ParticleSystem.h																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include "Rect.h"
+#include "Colors.h"
+#include <ostream>
+
+class Surface;
+
+// structure-of-arrays particle store: every attribute lives in its own 16-byte aligned
+// array (padded to a multiple of 4) so Update integrates four particles per instruction
+// dead particles are compacted in place by moving the last live particle into their slot,
+// so nothing is allocated after construction
+class ParticleSystem
+{
+public:
+	ParticleSystem( unsigned int capacity );
+	ParticleSystem( const ParticleSystem& ) = delete;
+	ParticleSystem& operator=( const ParticleSystem& ) = delete;
+	~ParticleSystem();
+	// false when the system is full
+	bool Emit( Vec2 pos,Vec2 vel,float life,Color color );
+	// advance dt seconds under constant acceleration, then drop expired particles
+	void Update( float dt,Vec2 accel );
+	// additively blit sprite (a rect of atlas) centred on every particle, tinted by the
+	// particle's colour and faded out over its last second of life
+	void Draw( Surface& target,const Surface& atlas,const RectI& sprite ) const;
+	void Clear();
+	unsigned int GetCount() const;
+	unsigned int GetCapacity() const;
+	// times Update and Draw from 1k to 1M particles
+	static void Benchmark( std::wostream& report );
+private:
+	void Kill( unsigned int i );
+private:
+	unsigned int capacity;
+	unsigned int count;
+	float* posX;
+	float* posY;
+	float* velX;
+	float* velY;
+	float* life;
+	Color* color;
+};
\ No newline at end of file
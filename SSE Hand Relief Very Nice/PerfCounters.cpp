@@ -0,0 +1,189 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	PerfCounters.cpp																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "PerfCounters.h"
+#include <string.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <x86intrin.h>
+#include <cpuid.h>
+#else
+#include "Cpuid.h"
+#include <intrin.h>
+#include <emmintrin.h>
+#endif
+
+#ifdef __linux__
+// Cpuid.h is MSVC only; CPUID.80000001h:EDX bit 27 is the same flag InstructionSet::RDTSCP reads
+static bool HasRdtscp()
+{
+	unsigned int eax,ebx,ecx,edx;
+	return __get_cpuid( 0x80000001,&eax,&ebx,&ecx,&edx ) != 0 && ( edx & ( 1u << 27 ) ) != 0;
+}
+
+static int OpenEvent( unsigned int type,unsigned long long config,int groupFd )
+{
+	perf_event_attr attr;
+	memset( &attr,0,sizeof( attr ) );
+	attr.size = sizeof( attr );
+	attr.type = type;
+	attr.config = config;
+	// the group leader starts disabled, members follow the leader
+	attr.disabled = groupFd == -1 ? 1 : 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+	return (int)syscall( __NR_perf_event_open,&attr,0,-1,groupFd,0 );
+}
+#else
+static bool HasRdtscp()
+{
+	return InstructionSet::RDTSCP();
+}
+#endif
+
+PerfCounters::PerfCounters()
+	:
+	opened( false ),
+	useRdtscp( HasRdtscp() ),
+	startTsc( 0 )
+{
+	for( int i = 0; i < nEvents; i++ )
+	{
+		fds[i] = -1;
+		ids[i] = ~0ull;
+	}
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+	// members before the leader
+	for( int i = nEvents - 1; i >= 0; i-- )
+	{
+		if( fds[i] != -1 )
+		{
+			close( fds[i] );
+		}
+	}
+#endif
+}
+
+void PerfCounters::Open()
+{
+	opened = true;
+#ifdef __linux__
+	// pid 0 in OpenEvent binds the group to the calling thread
+	fds[Cycles] = OpenEvent( PERF_TYPE_HARDWARE,PERF_COUNT_HW_CPU_CYCLES,-1 );
+	if( fds[Cycles] != -1 )
+	{
+		fds[Instructions] = OpenEvent( PERF_TYPE_HARDWARE,PERF_COUNT_HW_INSTRUCTIONS,fds[Cycles] );
+		fds[L1Misses] = OpenEvent( PERF_TYPE_HW_CACHE,PERF_COUNT_HW_CACHE_L1D |
+			( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ),fds[Cycles] );
+		fds[LlcMisses] = OpenEvent( PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES,fds[Cycles] );
+		fds[BranchMisses] = OpenEvent( PERF_TYPE_HARDWARE,PERF_COUNT_HW_BRANCH_MISSES,fds[Cycles] );
+		// group reads tag each value with its event id
+		for( int i = 0; i < nEvents; i++ )
+		{
+			if( fds[i] != -1 )
+			{
+				ioctl( fds[i],PERF_EVENT_IOC_ID,&ids[i] );
+			}
+		}
+	}
+#endif
+}
+
+void PerfCounters::Start()
+{
+	if( !opened )
+	{
+		Open();
+	}
+#ifdef __linux__
+	if( fds[Cycles] != -1 )
+	{
+		ioctl( fds[Cycles],PERF_EVENT_IOC_RESET,PERF_IOC_FLAG_GROUP );
+		ioctl( fds[Cycles],PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP );
+		return;
+	}
+#endif
+	startTsc = ReadTsc();
+}
+
+PerfCounters::Sample PerfCounters::Stop()
+{
+	Sample s;
+#ifdef __linux__
+	if( fds[Cycles] != -1 )
+	{
+		ioctl( fds[Cycles],PERF_EVENT_IOC_DISABLE,PERF_IOC_FLAG_GROUP );
+		// PERF_FORMAT_GROUP | PERF_FORMAT_ID: nr, then { value,id } per open event
+		unsigned long long data[1 + 2 * nEvents];
+		if( read( fds[Cycles],data,sizeof( data ) ) > 0 )
+		{
+			unsigned long long* const fields[nEvents] =
+				{ &s.cycles,&s.instructions,&s.l1Misses,&s.llcMisses,&s.branchMisses };
+			for( unsigned long long n = 0; n < data[0] && n < nEvents; n++ )
+			{
+				for( int i = 0; i < nEvents; i++ )
+				{
+					if( ids[i] == data[2 + 2 * n] )
+					{
+						*fields[i] = data[1 + 2 * n];
+					}
+				}
+			}
+		}
+		return s;
+	}
+#endif
+	s.cycles = ReadTsc() - startTsc;
+	return s;
+}
+
+bool PerfCounters::HasEvent( Event e ) const
+{
+	// the TSC fallback always provides (reference) cycles
+	return e == Cycles || fds[e] != -1;
+}
+
+bool PerfCounters::HasCoreCycles() const
+{
+	return fds[Cycles] != -1;
+}
+
+unsigned long long PerfCounters::ReadTsc() const
+{
+	if( useRdtscp )
+	{
+		// rdtscp waits for earlier instructions to retire, so no extra fence is needed
+		unsigned int aux;
+		return __rdtscp( &aux );
+	}
+	else
+	{
+		_mm_lfence();
+		return __rdtsc();
+	}
+}
\ No newline at end of file
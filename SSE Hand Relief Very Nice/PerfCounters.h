@@ -0,0 +1,98 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	PerfCounters.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+// hardware event counters around a region of code
+// on Linux a perf_event_open group counts core cycles, instructions, L1D read misses,
+// last level cache misses and branch misses; where that is unavailable (other platforms,
+// containers without perf access) only the time stamp counter is read, with rdtscp when
+// InstructionSet::RDTSCP says so and lfence + rdtsc otherwise
+// perf events count only the thread that opened them, so the group is opened by the first
+// Start and every Start/Stop must then come from that same thread; HasEvent and
+// HasCoreCycles report the TSC fallback until that first Start
+class PerfCounters
+{
+public:
+	struct Sample
+	{
+		Sample()
+			:
+			cycles( 0 ),
+			instructions( 0 ),
+			l1Misses( 0 ),
+			llcMisses( 0 ),
+			branchMisses( 0 )
+		{}
+		Sample& operator+=( const Sample& rhs )
+		{
+			cycles += rhs.cycles;
+			instructions += rhs.instructions;
+			l1Misses += rhs.l1Misses;
+			llcMisses += rhs.llcMisses;
+			branchMisses += rhs.branchMisses;
+			return *this;
+		}
+		Sample operator-( const Sample& rhs ) const
+		{
+			Sample diff;
+			diff.cycles = cycles - rhs.cycles;
+			diff.instructions = instructions - rhs.instructions;
+			diff.l1Misses = l1Misses - rhs.l1Misses;
+			diff.llcMisses = llcMisses - rhs.llcMisses;
+			diff.branchMisses = branchMisses - rhs.branchMisses;
+			return diff;
+		}
+		unsigned long long cycles;
+		unsigned long long instructions;
+		unsigned long long l1Misses;
+		unsigned long long llcMisses;
+		unsigned long long branchMisses;
+	};
+	enum Event
+	{
+		Cycles,
+		Instructions,
+		L1Misses,
+		LlcMisses,
+		BranchMisses,
+		nEvents
+	};
+public:
+	PerfCounters();
+	~PerfCounters();
+	PerfCounters( const PerfCounters& ) = delete;
+	PerfCounters& operator=( const PerfCounters& ) = delete;
+	void Start();
+	Sample Stop();
+	// false for events that could not be opened (their Sample fields stay 0)
+	bool HasEvent( Event e ) const;
+	// true if cycles are core clock cycles, false if they are constant rate TSC ticks
+	bool HasCoreCycles() const;
+private:
+	void Open();
+	unsigned long long ReadTsc() const;
+private:
+	bool opened;
+	int fds[nEvents];
+	unsigned long long ids[nEvents];
+	bool useRdtscp;
+	unsigned long long startTsc;
+};
\ No newline at end of file
@@ -0,0 +1,423 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	PixelFormat.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "PixelPipeline.h"
+#include <immintrin.h>
+
+// storage formats for PixelSurface and the row kernels that move pixels between them
+// and 32-bit Color; a format is a policy with a storage Type and scalar
+// ToColor / FromColor, and Unpack< Format,Isa > / Pack< Format,Isa > stamp out the row
+// loops the same way Pixel::Row does (the SSE2 kernels must match the scalar ones
+// bit for bit, since they finish their rows with them)
+namespace PixelFormat
+{
+	// the native Surface format
+	struct ARGB8888
+	{
+		typedef Color Type;
+		static Color ToColor( Type p )
+		{
+			return p;
+		}
+		static Type FromColor( Color c )
+		{
+			return c;
+		}
+	};
+
+	// alpha / coverage only (masks, glyphs); expands to white with that alpha
+	struct A8
+	{
+		typedef unsigned char Type;
+		static Color ToColor( Type a )
+		{
+			return Color( a,255,255,255 );
+		}
+		static Type FromColor( Color c )
+		{
+			return c.x;
+		}
+	};
+
+	// luminance only (lightmaps, heightfields); packs with BT.601 weights
+	struct L8
+	{
+		typedef unsigned char Type;
+		static Color ToColor( Type l )
+		{
+			return Color( 255,l,l,l );
+		}
+		static Type FromColor( Color c )
+		{
+			return Type( ( c.r * 77 + c.g * 150 + c.b * 29 + 128 ) >> 8 );
+		}
+	};
+
+	// 5:6:5 opaque colour; expands by bit replication so 0 and full scale map exactly
+	struct RGB565
+	{
+		typedef unsigned short Type;
+		static Color ToColor( Type p )
+		{
+			const unsigned int r = ( p >> 11 ) & 0x1F;
+			const unsigned int g = ( p >> 5 ) & 0x3F;
+			const unsigned int b = p & 0x1F;
+			return Color( 255,
+				( r << 3 ) | ( r >> 2 ),
+				( g << 2 ) | ( g >> 4 ),
+				( b << 3 ) | ( b >> 2 ) );
+		}
+		static Type FromColor( Color c )
+		{
+			return Type( ( ( c.r >> 3 ) << 11 ) | ( ( c.g >> 2 ) << 5 ) | ( c.b >> 3 ) );
+		}
+	};
+
+	// 8-bit palette index; has no ToColor / FromColor since the palette belongs to the
+	// surface (see IndexedSurface and the Expand kernels below)
+	struct I8
+	{
+		typedef unsigned char Type;
+	};
+
+	// Format -> Color
+	template< class Format,class Isa >
+	struct Unpack;
+
+	template< class Format >
+	struct Unpack< Format,Pixel::Scalar >
+	{
+		static void Run( Color* pDst,const typename Format::Type* pSrc,unsigned int nPixels )
+		{
+			for( Color* end = pDst + nPixels; pDst < end; pDst++,pSrc++ )
+			{
+				*pDst = Format::ToColor( *pSrc );
+			}
+		}
+	};
+
+	// Color -> Format
+	template< class Format,class Isa >
+	struct Pack;
+
+	template< class Format >
+	struct Pack< Format,Pixel::Scalar >
+	{
+		static void Run( typename Format::Type* pDst,const Color* pSrc,unsigned int nPixels )
+		{
+			for( typename Format::Type* end = pDst + nPixels; pDst < end; pDst++,pSrc++ )
+			{
+				*pDst = Format::FromColor( *pSrc );
+			}
+		}
+	};
+
+	template<>
+	struct Unpack< ARGB8888,Pixel::SSE2 >
+	{
+		static void Run( Color* pDst,const Color* pSrc,unsigned int nPixels )
+		{
+			memcpy( pDst,pSrc,nPixels * sizeof( Color ) );
+		}
+	};
+
+	template<>
+	struct Pack< ARGB8888,Pixel::SSE2 >
+	{
+		static void Run( Color* pDst,const Color* pSrc,unsigned int nPixels )
+		{
+			memcpy( pDst,pSrc,nPixels * sizeof( Color ) );
+		}
+	};
+
+	namespace Detail
+	{
+		// widen 16 bytes to 16 pixels with the byte in the alpha channel
+		inline void StoreAlphaBytes( Color* pDst,__m128i a,__m128i rgb )
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i lo16 = _mm_unpacklo_epi8( zero,a );
+			const __m128i hi16 = _mm_unpackhi_epi8( zero,a );
+			__m128i* const p = reinterpret_cast<__m128i*>( pDst );
+			_mm_storeu_si128( p,_mm_or_si128( _mm_unpacklo_epi16( zero,lo16 ),rgb ) );
+			_mm_storeu_si128( p + 1,_mm_or_si128( _mm_unpackhi_epi16( zero,lo16 ),rgb ) );
+			_mm_storeu_si128( p + 2,_mm_or_si128( _mm_unpacklo_epi16( zero,hi16 ),rgb ) );
+			_mm_storeu_si128( p + 3,_mm_or_si128( _mm_unpackhi_epi16( zero,hi16 ),rgb ) );
+		}
+		// narrow four vectors of 32-bit lanes holding values 0-255 to 16 bytes
+		inline __m128i Narrow32To8( __m128i a,__m128i b,__m128i c,__m128i d )
+		{
+			return _mm_packus_epi16( _mm_packs_epi32( a,b ),_mm_packs_epi32( c,d ) );
+		}
+		inline __m128i Load( const Color* p )
+		{
+			return _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+		}
+	}
+
+	template<>
+	struct Unpack< A8,Pixel::SSE2 >
+	{
+		static void Run( Color* pDst,const unsigned char* pSrc,unsigned int nPixels )
+		{
+			const __m128i white = _mm_set1_epi32( 0x00FFFFFF );
+			for( Color* end = pDst + ( nPixels & ~15u ); pDst < end; pDst += 16,pSrc += 16 )
+			{
+				Detail::StoreAlphaBytes( pDst,_mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc ) ),white );
+			}
+			Unpack< A8,Pixel::Scalar >::Run( pDst,pSrc,nPixels & 15u );
+		}
+	};
+
+	template<>
+	struct Pack< A8,Pixel::SSE2 >
+	{
+		static void Run( unsigned char* pDst,const Color* pSrc,unsigned int nPixels )
+		{
+			for( unsigned char* end = pDst + ( nPixels & ~15u ); pDst < end; pDst += 16,pSrc += 16 )
+			{
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( pDst ),Detail::Narrow32To8(
+					_mm_srli_epi32( Detail::Load( pSrc ),24 ),
+					_mm_srli_epi32( Detail::Load( pSrc + 4 ),24 ),
+					_mm_srli_epi32( Detail::Load( pSrc + 8 ),24 ),
+					_mm_srli_epi32( Detail::Load( pSrc + 12 ),24 ) ) );
+			}
+			Pack< A8,Pixel::Scalar >::Run( pDst,pSrc,nPixels & 15u );
+		}
+	};
+
+	template<>
+	struct Unpack< L8,Pixel::SSE2 >
+	{
+		static void Run( Color* pDst,const unsigned char* pSrc,unsigned int nPixels )
+		{
+			const __m128i opaque = _mm_set1_epi32( 0xFF000000 );
+			for( Color* end = pDst + ( nPixels & ~15u ); pDst < end; pDst += 16,pSrc += 16 )
+			{
+				// l -> ll -> llll, then force alpha
+				const __m128i l = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc ) );
+				const __m128i lo16 = _mm_unpacklo_epi8( l,l );
+				const __m128i hi16 = _mm_unpackhi_epi8( l,l );
+				__m128i* const p = reinterpret_cast<__m128i*>( pDst );
+				_mm_storeu_si128( p,_mm_or_si128( _mm_unpacklo_epi16( lo16,lo16 ),opaque ) );
+				_mm_storeu_si128( p + 1,_mm_or_si128( _mm_unpackhi_epi16( lo16,lo16 ),opaque ) );
+				_mm_storeu_si128( p + 2,_mm_or_si128( _mm_unpacklo_epi16( hi16,hi16 ),opaque ) );
+				_mm_storeu_si128( p + 3,_mm_or_si128( _mm_unpackhi_epi16( hi16,hi16 ),opaque ) );
+			}
+			Unpack< L8,Pixel::Scalar >::Run( pDst,pSrc,nPixels & 15u );
+		}
+	};
+
+	template<>
+	struct Pack< L8,Pixel::SSE2 >
+	{
+		static void Run( unsigned char* pDst,const Color* pSrc,unsigned int nPixels )
+		{
+			for( unsigned char* end = pDst + ( nPixels & ~15u ); pDst < end; pDst += 16,pSrc += 16 )
+			{
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( pDst ),Detail::Narrow32To8(
+					Luma( Detail::Load( pSrc ) ),
+					Luma( Detail::Load( pSrc + 4 ) ),
+					Luma( Detail::Load( pSrc + 8 ) ),
+					Luma( Detail::Load( pSrc + 12 ) ) ) );
+			}
+			Pack< L8,Pixel::Scalar >::Run( pDst,pSrc,nPixels & 15u );
+		}
+	private:
+		// every product fits in the low 16 bits of its 32-bit lane, so mullo_epi16 is exact
+		static __m128i Luma( __m128i p )
+		{
+			const __m128i byteMask = _mm_set1_epi32( 0xFF );
+			const __m128i r = _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi32( p,16 ),byteMask ),_mm_set1_epi32( 77 ) );
+			const __m128i g = _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi32( p,8 ),byteMask ),_mm_set1_epi32( 150 ) );
+			const __m128i b = _mm_mullo_epi16( _mm_and_si128( p,byteMask ),_mm_set1_epi32( 29 ) );
+			return _mm_srli_epi32( _mm_add_epi32( _mm_add_epi32( r,g ),
+				_mm_add_epi32( b,_mm_set1_epi32( 128 ) ) ),8 );
+		}
+	};
+
+	template<>
+	struct Unpack< RGB565,Pixel::SSE2 >
+	{
+		static void Run( Color* pDst,const unsigned short* pSrc,unsigned int nPixels )
+		{
+			const __m128i mask5 = _mm_set1_epi16( 0x1F );
+			const __m128i mask6 = _mm_set1_epi16( 0x3F );
+			const __m128i opaque = _mm_set1_epi16( (short)0xFF00 );
+			for( Color* end = pDst + ( nPixels & ~7u ); pDst < end; pDst += 8,pSrc += 8 )
+			{
+				const __m128i p = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc ) );
+				const __m128i r5 = _mm_srli_epi16( p,11 );
+				const __m128i g6 = _mm_and_si128( _mm_srli_epi16( p,5 ),mask6 );
+				const __m128i b5 = _mm_and_si128( p,mask5 );
+				const __m128i r8 = _mm_or_si128( _mm_slli_epi16( r5,3 ),_mm_srli_epi16( r5,2 ) );
+				const __m128i g8 = _mm_or_si128( _mm_slli_epi16( g6,2 ),_mm_srli_epi16( g6,4 ) );
+				const __m128i b8 = _mm_or_si128( _mm_slli_epi16( b5,3 ),_mm_srli_epi16( b5,2 ) );
+				// 16-bit lanes of g:b and a:r interleave into b g r a pixels
+				const __m128i gb = _mm_or_si128( _mm_slli_epi16( g8,8 ),b8 );
+				const __m128i ar = _mm_or_si128( opaque,r8 );
+				__m128i* const pOut = reinterpret_cast<__m128i*>( pDst );
+				_mm_storeu_si128( pOut,_mm_unpacklo_epi16( gb,ar ) );
+				_mm_storeu_si128( pOut + 1,_mm_unpackhi_epi16( gb,ar ) );
+			}
+			Unpack< RGB565,Pixel::Scalar >::Run( pDst,pSrc,nPixels & 7u );
+		}
+	};
+
+	template<>
+	struct Pack< RGB565,Pixel::SSE2 >
+	{
+		static void Run( unsigned short* pDst,const Color* pSrc,unsigned int nPixels )
+		{
+			for( unsigned short* end = pDst + ( nPixels & ~7u ); pDst < end; pDst += 8,pSrc += 8 )
+			{
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( pDst ),_mm_packs_epi32(
+					To565( Detail::Load( pSrc ) ),To565( Detail::Load( pSrc + 4 ) ) ) );
+			}
+			Pack< RGB565,Pixel::Scalar >::Run( pDst,pSrc,nPixels & 7u );
+		}
+	private:
+		// result is sign extended from 16 bits so packs_epi32 keeps the bit pattern
+		static __m128i To565( __m128i p )
+		{
+			const __m128i r = _mm_and_si128( _mm_srli_epi32( p,8 ),_mm_set1_epi32( 0xF800 ) );
+			const __m128i g = _mm_and_si128( _mm_srli_epi32( p,5 ),_mm_set1_epi32( 0x07E0 ) );
+			const __m128i b = _mm_and_si128( _mm_srli_epi32( p,3 ),_mm_set1_epi32( 0x001F ) );
+			return _mm_srai_epi32( _mm_slli_epi32( _mm_or_si128( _mm_or_si128( r,g ),b ),16 ),16 );
+		}
+	};
+
+	// dst = dst lerped toward colour by coverage * colour alpha (glyph / mask drawing)
+	// the source pixel is built in ARGB and handed to Pixel::PerPixelAlpha, so the
+	// result matches BltAlpha of the equivalent 32-bit sprite exactly
+	template< class Isa >
+	struct Coverage;
+
+	template<>
+	struct Coverage< Pixel::Scalar >
+	{
+		static void Run( Color* pDst,const unsigned char* pCoverage,unsigned int nPixels,Color c )
+		{
+			const Pixel::PerPixelAlpha mode;
+			for( Color* end = pDst + nPixels; pDst < end; pDst++,pCoverage++ )
+			{
+				const unsigned char a = (unsigned char)Pixel::Detail::Mul255( *pCoverage,c.x );
+				*pDst = mode.Blend( *pDst,Color( a,c ) );
+			}
+		}
+	};
+
+	template<>
+	struct Coverage< Pixel::SSE2 >
+	{
+		static void Run( Color* pDst,const unsigned char* pCoverage,unsigned int nPixels,Color c )
+		{
+			const Pixel::PerPixelAlpha mode;
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i rgb = _mm_set1_epi32( c & 0x00FFFFFF );
+			const __m128i alpha16 = _mm_set1_epi16( c.x );
+			for( Color* end = pDst + ( nPixels & ~7u ); pDst < end; pDst += 8,pCoverage += 8 )
+			{
+				const __m128i cov16 = _mm_unpacklo_epi8(
+					_mm_loadl_epi64( reinterpret_cast<const __m128i*>( pCoverage ) ),zero );
+				const __m128i a16 = Pixel::Detail::Mul255( cov16,alpha16 );
+				// alpha words -> top byte of each pixel
+				const __m128i sLo = _mm_or_si128( _mm_slli_epi32( _mm_unpacklo_epi16( a16,zero ),24 ),rgb );
+				const __m128i sHi = _mm_or_si128( _mm_slli_epi32( _mm_unpackhi_epi16( a16,zero ),24 ),rgb );
+				__m128i* const p = reinterpret_cast<__m128i*>( pDst );
+				_mm_storeu_si128( p,mode.Blend( _mm_loadu_si128( p ),sLo ) );
+				_mm_storeu_si128( p + 1,mode.Blend( _mm_loadu_si128( p + 1 ),sHi ) );
+			}
+			Coverage< Pixel::Scalar >::Run( pDst,pCoverage,nPixels & 7u,c );
+		}
+	};
+
+	// palette index -> Color; the SSE2 flavour is the scalar loop since SSE has no gather
+	// key = -1 writes every pixel, otherwise pixels with index key leave dst untouched
+	template< class Isa >
+	struct Expand;
+
+	template<>
+	struct Expand< Pixel::Scalar >
+	{
+		static void Run( Color* pDst,const unsigned char* pSrc,unsigned int nPixels,
+			const Color* palette,int key = -1 )
+		{
+			if( key < 0 )
+			{
+				for( Color* end = pDst + nPixels; pDst < end; pDst++,pSrc++ )
+				{
+					*pDst = palette[*pSrc];
+				}
+			}
+			else
+			{
+				for( Color* end = pDst + nPixels; pDst < end; pDst++,pSrc++ )
+				{
+					if( *pSrc != key )
+					{
+						*pDst = palette[*pSrc];
+					}
+				}
+			}
+		}
+	};
+
+	template<>
+	struct Expand< Pixel::SSE2 > : public Expand< Pixel::Scalar >
+	{};
+
+	template<>
+	struct Expand< Pixel::AVX2 >
+	{
+		// 8 indices widened to dwords drive one gather from the palette
+		static void Run( Color* pDst,const unsigned char* pSrc,unsigned int nPixels,
+			const Color* palette,int key = -1 )
+		{
+			const int* const table = reinterpret_cast<const int*>( palette );
+			Color* const end = pDst + ( nPixels & ~7u );
+			if( key < 0 )
+			{
+				for( ; pDst < end; pDst += 8,pSrc += 8 )
+				{
+					const __m256i index = _mm256_cvtepu8_epi32(
+						_mm_loadl_epi64( reinterpret_cast<const __m128i*>( pSrc ) ) );
+					_mm256_storeu_si256( reinterpret_cast<__m256i*>( pDst ),
+						_mm256_i32gather_epi32( table,index,4 ) );
+				}
+			}
+			else
+			{
+				const __m256i keyIndex = _mm256_set1_epi32( key );
+				for( ; pDst < end; pDst += 8,pSrc += 8 )
+				{
+					const __m256i index = _mm256_cvtepu8_epi32(
+						_mm_loadl_epi64( reinterpret_cast<const __m128i*>( pSrc ) ) );
+					__m256i* const p = reinterpret_cast<__m256i*>( pDst );
+					_mm256_storeu_si256( p,_mm256_blendv_epi8( _mm256_i32gather_epi32( table,index,4 ),
+						_mm256_loadu_si256( p ),_mm256_cmpeq_epi32( index,keyIndex ) ) );
+				}
+			}
+			Expand< Pixel::Scalar >::Run( pDst,pSrc,nPixels & 7u,palette,key );
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	PixelPipeline.cpp																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "PixelPipeline.h"
+#include <math.h>
+
+namespace Pixel
+{
+	namespace Detail
+	{
+		unsigned short srgbToLinear[256];
+		unsigned char linearToSrgb[4096];
+
+		namespace
+		{
+			// builds both tables before main; nothing composes during static initialization
+			struct GammaTables
+			{
+				GammaTables()
+				{
+					for( int i = 0; i < 256; i++ )
+					{
+						const double c = i / 255.0;
+						const double linear = c <= 0.04045 ? c / 12.92 : pow( ( c + 0.055 ) / 1.055,2.4 );
+						srgbToLinear[i] = (unsigned short)( linear * 65535.0 + 0.5 );
+					}
+					for( int i = 0; i < 4096; i++ )
+					{
+						// centre of the 16 linear values that share this entry
+						const double linear = ( i * 16 + 7.5 ) / 65535.0;
+						const double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * pow( linear,1.0 / 2.4 ) - 0.055;
+						linearToSrgb[i] = (unsigned char)( c * 255.0 + 0.5 );
+					}
+				}
+			} gammaTables;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,636 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	PixelPipeline.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Colors.h"
+#include <emmintrin.h>
+
+// compile-time pixel pipeline used by Surface::Compose
+// a blend mode is a small functor with two Blend overloads: one pixel (Color) and four
+// pixels (__m128i, SSE2); Row< Mode,Isa > stamps out the row loop for one mode / ISA pair,
+// so every combination becomes its own fully inlined kernel with no runtime dispatch
+// both overloads of a mode must produce bit-identical results (Row< Mode,SSE2 > finishes
+// rows that aren't a multiple of 4 pixels with the scalar overload)
+namespace Pixel
+{
+	// instruction set policies
+	struct Scalar {};
+	struct SSE2 {};
+	// only kernels that need gathers have AVX2 versions; callers must check
+	// InstructionSet::AVX2() before picking them
+	struct AVX2 {};
+
+	namespace Detail
+	{
+		// x * y / 255, correctly rounded for all 8-bit inputs
+		inline unsigned int Mul255( unsigned int x,unsigned int y )
+		{
+			const unsigned int t = x * y + 128;
+			return ( t + ( t >> 8 ) ) >> 8;
+		}
+		inline __m128i Mul255( __m128i x16,__m128i y16 )
+		{
+			const __m128i t = _mm_add_epi16( _mm_mullo_epi16( x16,y16 ),_mm_set1_epi16( 128 ) );
+			return _mm_srli_epi16( _mm_add_epi16( t,_mm_srli_epi16( t,8 ) ),8 );
+		}
+		// apply f( dst channel,src channel ) to all four channels
+		template< class F >
+		inline Color PerChannel( Color d,Color s,F f )
+		{
+			return Color(
+				(unsigned char)f( d.x,s.x ),
+				(unsigned char)f( d.r,s.r ),
+				(unsigned char)f( d.g,s.g ),
+				(unsigned char)f( d.b,s.b ) );
+		}
+		// apply f( dst channels,src channels ) to four pixels widened to 16-bit lanes
+		template< class F >
+		inline __m128i PerChannel16( __m128i d,__m128i s,F f )
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i rsltLo16 = f( _mm_unpacklo_epi8( d,zero ),_mm_unpacklo_epi8( s,zero ) );
+			const __m128i rsltHi16 = f( _mm_unpackhi_epi8( d,zero ),_mm_unpackhi_epi8( s,zero ) );
+			return _mm_packus_epi16( rsltLo16,rsltHi16 );
+		}
+		// broadcast each pixel's alpha across its four 16-bit lanes
+		inline __m128i AlphaOf16( __m128i p16 )
+		{
+			const __m128i alpha = _mm_shufflelo_epi16( p16,_MM_SHUFFLE( 3,3,3,3 ) );
+			return _mm_shufflehi_epi16( alpha,_MM_SHUFFLE( 3,3,3,3 ) );
+		}
+		// sRGB byte -> linear light scaled to 0..65535, and linear light >> 4 -> sRGB byte
+		// (filled during static initialization in PixelPipeline.cpp)
+		extern unsigned short srgbToLinear[256];
+		extern unsigned char linearToSrgb[4096];
+		// ( d * ( 255 - a ) + s * a ) / 256, the lerp used throughout Surface
+		inline __m128i Lerp16( __m128i d16,__m128i s16,__m128i alpha16 )
+		{
+			const __m128i calpha16 = _mm_sub_epi16( _mm_set1_epi16( 0x00FF ),alpha16 );
+			return _mm_srli_epi16( _mm_add_epi16(
+				_mm_mullo_epi16( d16,calpha16 ),_mm_mullo_epi16( s16,alpha16 ) ),8 );
+		}
+	}
+
+	// dst = src
+	class Copy
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			return s;
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			return s;
+		}
+	};
+
+	// lerp by a constant alpha
+	class ConstantAlpha
+	{
+	public:
+		ConstantAlpha( unsigned char alpha )
+			:
+			alpha( alpha )
+		{}
+		Color Blend( Color d,Color s ) const
+		{
+			const unsigned int a = alpha;
+			return Detail::PerChannel( d,s,[a]( unsigned int dc,unsigned int sc )
+			{
+				return ( dc * ( 255 - a ) + sc * a ) >> 8;
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			const __m128i alpha16 = _mm_set1_epi16( alpha );
+			return Detail::PerChannel16( d,s,[alpha16]( __m128i d16,__m128i s16 )
+			{
+				return Detail::Lerp16( d16,s16,alpha16 );
+			} );
+		}
+	private:
+		unsigned char alpha;
+	};
+
+	// lerp by the source pixel's alpha
+	class PerPixelAlpha
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			const unsigned int a = s.x;
+			return Detail::PerChannel( d,s,[a]( unsigned int dc,unsigned int sc )
+			{
+				return ( dc * ( 255 - a ) + sc * a ) >> 8;
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			return Detail::PerChannel16( d,s,[]( __m128i d16,__m128i s16 )
+			{
+				return Detail::Lerp16( d16,s16,Detail::AlphaOf16( s16 ) );
+			} );
+		}
+	};
+
+	// source already multiplied by its alpha (see Surface::PremultiplyAlpha)
+	// dst = dst * ( 255 - a ) / 256 + src, saturated
+	class Premultiplied
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			const unsigned int ca = 255 - s.x;
+			return Detail::PerChannel( d,s,[ca]( unsigned int dc,unsigned int sc )
+			{
+				return min( ( ( dc * ca ) >> 8 ) + sc,255u );
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i ones = _mm_set1_epi16( 0x00FF );
+			const __m128i dLo16 = _mm_unpacklo_epi8( d,zero );
+			const __m128i dHi16 = _mm_unpackhi_epi8( d,zero );
+			const __m128i caLo16 = _mm_sub_epi16( ones,Detail::AlphaOf16( _mm_unpacklo_epi8( s,zero ) ) );
+			const __m128i caHi16 = _mm_sub_epi16( ones,Detail::AlphaOf16( _mm_unpackhi_epi8( s,zero ) ) );
+			const __m128i rsltLo16 = _mm_srli_epi16( _mm_mullo_epi16( dLo16,caLo16 ),8 );
+			const __m128i rsltHi16 = _mm_srli_epi16( _mm_mullo_epi16( dHi16,caHi16 ),8 );
+			return _mm_adds_epu8( _mm_packus_epi16( rsltLo16,rsltHi16 ),s );
+		}
+	};
+
+	// dst = dst + src, saturated
+	class Additive
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			return Detail::PerChannel( d,s,[]( unsigned int dc,unsigned int sc )
+			{
+				return min( dc + sc,255u );
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			return _mm_adds_epu8( d,s );
+		}
+		int BlendPremultiplied( unsigned int cb,unsigned int cs,unsigned int as ) const
+		{
+			return Detail::Mul255( cb,as ) + cs;
+		}
+		__m128i BlendPremultiplied( __m128i cb16,__m128i cs16,__m128i as16 ) const
+		{
+			return _mm_add_epi16( Detail::Mul255( cb16,as16 ),cs16 );
+		}
+	};
+
+	// dst = dst * src / 255
+	class Multiply
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			return Detail::PerChannel( d,s,[]( unsigned int dc,unsigned int sc )
+			{
+				return Detail::Mul255( dc,sc );
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			return Detail::PerChannel16( d,s,[]( __m128i d16,__m128i s16 )
+			{
+				return Detail::Mul255( d16,s16 );
+			} );
+		}
+		int BlendPremultiplied( unsigned int cb,unsigned int cs,unsigned int as ) const
+		{
+			return Detail::Mul255( cb,cs );
+		}
+		__m128i BlendPremultiplied( __m128i cb16,__m128i cs16,__m128i as16 ) const
+		{
+			return Detail::Mul255( cb16,cs16 );
+		}
+	};
+
+	// dst = 255 - ( 255 - dst ) * ( 255 - src ) / 255
+	class Screen
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			return Detail::PerChannel( d,s,[]( unsigned int dc,unsigned int sc )
+			{
+				return 255 - Detail::Mul255( 255 - dc,255 - sc );
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			const __m128i invert = _mm_set1_epi8( -1 );
+			return _mm_xor_si128( invert,Detail::PerChannel16(
+				_mm_xor_si128( d,invert ),_mm_xor_si128( s,invert ),
+				[]( __m128i d16,__m128i s16 )
+			{
+				return Detail::Mul255( d16,s16 );
+			} ) );
+		}
+		int BlendPremultiplied( unsigned int cb,unsigned int cs,unsigned int as ) const
+		{
+			return Detail::Mul255( cb,as ) + cs - Detail::Mul255( cb,cs );
+		}
+		__m128i BlendPremultiplied( __m128i cb16,__m128i cs16,__m128i as16 ) const
+		{
+			return _mm_sub_epi16( _mm_add_epi16( Detail::Mul255( cb16,as16 ),cs16 ),
+				Detail::Mul255( cb16,cs16 ) );
+		}
+	};
+
+	// dst = dst / 2 + src / 2 (each half truncated, so the sum never carries)
+	class HalfAverage
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			const unsigned int shiftMask = 0x7F7F7F7F;
+			return ( ( d >> 1 ) & shiftMask ) + ( ( s >> 1 ) & shiftMask );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			const __m128i shiftMask = _mm_set1_epi8( 0x7F );
+			return _mm_add_epi8(
+				_mm_and_si128( _mm_srli_epi16( d,1 ),shiftMask ),
+				_mm_and_si128( _mm_srli_epi16( s,1 ),shiftMask ) );
+		}
+	};
+
+	// dst = src unless src is the key color
+	class ColorKey
+	{
+	public:
+		ColorKey( Color key )
+			:
+			key( key )
+		{}
+		Color Blend( Color d,Color s ) const
+		{
+			return s == key ? d : s;
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			const __m128i isKey = _mm_cmpeq_epi32( s,_mm_set1_epi32( key ) );
+			return _mm_or_si128( _mm_and_si128( isKey,d ),_mm_andnot_si128( isKey,s ) );
+		}
+	private:
+		Color key;
+	};
+
+	// dst = dst - src, saturated
+	class Subtractive
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			return Detail::PerChannel( d,s,[]( unsigned int dc,unsigned int sc )
+			{
+				return dc > sc ? dc - sc : 0;
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			return _mm_subs_epu8( d,s );
+		}
+		// a * max( dst - src / a,0 ), clamped here so the term can't eat into dst * ( 255 - a )
+		int BlendPremultiplied( unsigned int cb,unsigned int cs,unsigned int as ) const
+		{
+			return max( (int)Detail::Mul255( cb,as ) - (int)cs,0 );
+		}
+		__m128i BlendPremultiplied( __m128i cb16,__m128i cs16,__m128i as16 ) const
+		{
+			return _mm_max_epi16( _mm_sub_epi16( Detail::Mul255( cb16,as16 ),cs16 ),_mm_setzero_si128() );
+		}
+	};
+
+	// dst = min( dst,src )
+	class Darken
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			return Detail::PerChannel( d,s,[]( unsigned int dc,unsigned int sc )
+			{
+				return min( dc,sc );
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			return _mm_min_epu8( d,s );
+		}
+		int BlendPremultiplied( unsigned int cb,unsigned int cs,unsigned int as ) const
+		{
+			return min( Detail::Mul255( cb,as ),cs );
+		}
+		__m128i BlendPremultiplied( __m128i cb16,__m128i cs16,__m128i as16 ) const
+		{
+			return _mm_min_epi16( Detail::Mul255( cb16,as16 ),cs16 );
+		}
+	};
+
+	// dst = max( dst,src )
+	class Lighten
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			return Detail::PerChannel( d,s,[]( unsigned int dc,unsigned int sc )
+			{
+				return max( dc,sc );
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			return _mm_max_epu8( d,s );
+		}
+		int BlendPremultiplied( unsigned int cb,unsigned int cs,unsigned int as ) const
+		{
+			return max( Detail::Mul255( cb,as ),cs );
+		}
+		__m128i BlendPremultiplied( __m128i cb16,__m128i cs16,__m128i as16 ) const
+		{
+			return _mm_max_epi16( Detail::Mul255( cb16,as16 ),cs16 );
+		}
+	};
+
+	// multiply where dst is dark, screen where dst is light (dst picks, src paints)
+	class Overlay
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			return Detail::PerChannel( d,s,[this]( unsigned int dc,unsigned int sc )
+			{
+				return BlendPremultiplied( dc,sc,255 );
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			const __m128i opaque16 = _mm_set1_epi16( 0x00FF );
+			return Detail::PerChannel16( d,s,[this,opaque16]( __m128i d16,__m128i s16 )
+			{
+				return BlendPremultiplied( d16,s16,opaque16 );
+			} );
+		}
+		int BlendPremultiplied( unsigned int cb,unsigned int cs,unsigned int as ) const
+		{
+			if( cb < 128 )
+			{
+				return 2 * Detail::Mul255( cb,cs );
+			}
+			return (int)as - 2 * (int)Detail::Mul255( 255 - cb,as > cs ? as - cs : 0 );
+		}
+		__m128i BlendPremultiplied( __m128i cb16,__m128i cs16,__m128i as16 ) const
+		{
+			const __m128i dark = _mm_cmplt_epi16( cb16,_mm_set1_epi16( 128 ) );
+			const __m128i darkRslt = _mm_slli_epi16( Detail::Mul255( cb16,cs16 ),1 );
+			const __m128i lightRslt = _mm_sub_epi16( as16,_mm_slli_epi16( Detail::Mul255(
+				_mm_sub_epi16( _mm_set1_epi16( 0x00FF ),cb16 ),_mm_subs_epu16( as16,cs16 ) ),1 ) );
+			return _mm_or_si128( _mm_and_si128( dark,darkRslt ),_mm_andnot_si128( dark,lightRslt ) );
+		}
+	};
+
+	// lerp by the source pixel's alpha in linear light instead of on the sRGB bytes, so
+	// antialiased edges and gradients don't darken; alpha 0 and 255 are exact and the dst
+	// alpha channel gets the usual byte lerp
+	// SSE2 has no gather, so the SIMD overload does its table lookups through memory and
+	// only the 16-bit lerp itself runs in vector registers
+	class LinearAlpha
+	{
+	public:
+		Color Blend( Color d,Color s ) const
+		{
+			const unsigned int a = s.x;
+			if( a == 0 )
+			{
+				return d;
+			}
+			if( a == 255 )
+			{
+				return s;
+			}
+			const unsigned int a16 = a * 257;
+			const unsigned int ca16 = 65535 - a16;
+			const Color rgb = Detail::PerChannel( d,s,[a16,ca16]( unsigned int dc,unsigned int sc )
+			{
+				const unsigned int linear = ( ( Detail::srgbToLinear[dc] * ca16 ) >> 16 ) +
+					( ( Detail::srgbToLinear[sc] * a16 ) >> 16 );
+				return Detail::linearToSrgb[linear >> 4];
+			} );
+			return Color( (unsigned char)( ( d.x * ( 255 - a ) + s.x * a ) >> 8 ),rgb );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i alphaLo16 = Detail::AlphaOf16( _mm_unpacklo_epi8( s,zero ) );
+			const __m128i alphaHi16 = Detail::AlphaOf16( _mm_unpackhi_epi8( s,zero ) );
+			const __m128i linearLo16 = Lerp16( ToLinear16( d,0 ),ToLinear16( s,0 ),alphaLo16 );
+			const __m128i linearHi16 = Lerp16( ToLinear16( d,8 ),ToLinear16( s,8 ),alphaHi16 );
+			const __m128i rgb = _mm_setr_epi32(
+				ToSrgb( linearLo16,0 ),ToSrgb( linearLo16,4 ),ToSrgb( linearHi16,0 ),ToSrgb( linearHi16,4 ) );
+			// colour from the linear lerp, alpha from the byte lerp
+			const __m128i alphaMask = _mm_set1_epi32( 0xFF000000 );
+			const __m128i alphaRslt = _mm_packus_epi16(
+				Detail::Lerp16( _mm_unpacklo_epi8( d,zero ),_mm_unpacklo_epi8( s,zero ),alphaLo16 ),
+				Detail::Lerp16( _mm_unpackhi_epi8( d,zero ),_mm_unpackhi_epi8( s,zero ),alphaHi16 ) );
+			const __m128i rslt = _mm_or_si128( rgb,_mm_and_si128( alphaMask,alphaRslt ) );
+			// exact endpoints
+			const __m128i sAlpha = _mm_and_si128( s,alphaMask );
+			const __m128i isClear = _mm_cmpeq_epi32( sAlpha,zero );
+			const __m128i isOpaque = _mm_cmpeq_epi32( sAlpha,alphaMask );
+			return _mm_or_si128( _mm_or_si128( _mm_and_si128( isClear,d ),_mm_and_si128( isOpaque,s ) ),
+				_mm_andnot_si128( _mm_or_si128( isClear,isOpaque ),rslt ) );
+		}
+	private:
+		// pixels 0,1 (half 0) or 2,3 (half 8) -> b g r 0 b g r 0 linear words
+		static __m128i ToLinear16( __m128i p,int half )
+		{
+			const __m128i pair = half == 0 ? p : _mm_srli_si128( p,8 );
+			const unsigned int p0 = _mm_cvtsi128_si32( pair );
+			const unsigned int p1 = _mm_cvtsi128_si32( _mm_srli_si128( pair,4 ) );
+			const unsigned short* const table = Detail::srgbToLinear;
+			return _mm_setr_epi16(
+				table[p0 & 0xFF],table[( p0 >> 8 ) & 0xFF],table[( p0 >> 16 ) & 0xFF],0,
+				table[p1 & 0xFF],table[( p1 >> 8 ) & 0xFF],table[( p1 >> 16 ) & 0xFF],0 );
+		}
+		// b g r words of pixel 0 (word 0) or 1 (word 4) -> sRGB pixel with zero alpha
+		static int ToSrgb( __m128i linear16,int word )
+		{
+			const unsigned char* const table = Detail::linearToSrgb;
+			if( word == 0 )
+			{
+				return table[_mm_extract_epi16( linear16,0 )] |
+					( table[_mm_extract_epi16( linear16,1 )] << 8 ) |
+					( table[_mm_extract_epi16( linear16,2 )] << 16 );
+			}
+			return table[_mm_extract_epi16( linear16,4 )] |
+				( table[_mm_extract_epi16( linear16,5 )] << 8 ) |
+				( table[_mm_extract_epi16( linear16,6 )] << 16 );
+		}
+		// ( d * ( 65535 - a16 ) >> 16 ) + ( s * a16 >> 16 ) >> 4, a16 = alpha * 257
+		static __m128i Lerp16( __m128i dLinear16,__m128i sLinear16,__m128i alpha16 )
+		{
+			const __m128i a16 = _mm_mullo_epi16( alpha16,_mm_set1_epi16( 257 ) );
+			const __m128i ca16 = _mm_xor_si128( a16,_mm_set1_epi16( -1 ) );
+			return _mm_srli_epi16( _mm_add_epi16( _mm_mulhi_epu16( dLinear16,ca16 ),
+				_mm_mulhi_epu16( sLinear16,a16 ) ),4 );
+		}
+	};
+
+	// multiply the source by a constant colour before handing it to Mode (tinted sprites)
+	template< class Mode >
+	class Modulated
+	{
+	public:
+		Modulated( Color tint,const Mode& mode = Mode() )
+			:
+			tint( tint ),
+			mode( mode )
+		{}
+		Color Blend( Color d,Color s ) const
+		{
+			return mode.Blend( d,Detail::PerChannel( s,tint,[]( unsigned int sc,unsigned int tc )
+			{
+				return Detail::Mul255( sc,tc );
+			} ) );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			return mode.Blend( d,Detail::PerChannel16( s,_mm_set1_epi32( tint ),[]( __m128i s16,__m128i t16 )
+			{
+				return Detail::Mul255( s16,t16 );
+			} ) );
+		}
+	private:
+		Color tint;
+		Mode mode;
+	};
+
+	// straight alpha source: apply Mode, then lerp from dst to the result by the source alpha
+	template< class Mode >
+	class Alpha
+	{
+	public:
+		Alpha( const Mode& mode = Mode() )
+			:
+			mode( mode )
+		{}
+		Color Blend( Color d,Color s ) const
+		{
+			const unsigned int a = s.x;
+			return Detail::PerChannel( d,mode.Blend( d,s ),[a]( unsigned int dc,unsigned int bc )
+			{
+				return ( dc * ( 255 - a ) + bc * a ) >> 8;
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i b = mode.Blend( d,s );
+			const __m128i rsltLo16 = Detail::Lerp16( _mm_unpacklo_epi8( d,zero ),_mm_unpacklo_epi8( b,zero ),
+				Detail::AlphaOf16( _mm_unpacklo_epi8( s,zero ) ) );
+			const __m128i rsltHi16 = Detail::Lerp16( _mm_unpackhi_epi8( d,zero ),_mm_unpackhi_epi8( b,zero ),
+				Detail::AlphaOf16( _mm_unpackhi_epi8( s,zero ) ) );
+			return _mm_packus_epi16( rsltLo16,rsltHi16 );
+		}
+	private:
+		Mode mode;
+	};
+
+	// premultiplied source (see Surface::PremultiplyAlpha) over an opaque dst:
+	// dst = dst * ( 255 - a ) / 255 + a * B( dst,src / a ), where Mode::BlendPremultiplied
+	// supplies the last term from the premultiplied channel; results are clamped to 0..255
+	template< class Mode >
+	class PremultipliedAlpha
+	{
+	public:
+		PremultipliedAlpha( const Mode& mode = Mode() )
+			:
+			mode( mode )
+		{}
+		Color Blend( Color d,Color s ) const
+		{
+			const unsigned int a = s.x;
+			const Mode& m = mode;
+			return Detail::PerChannel( d,s,[a,&m]( unsigned int dc,unsigned int sc )
+			{
+				const int rslt = (int)Detail::Mul255( dc,255 - a ) + m.BlendPremultiplied( dc,sc,a );
+				return rslt < 0 ? 0 : min( rslt,255 );
+			} );
+		}
+		__m128i Blend( __m128i d,__m128i s ) const
+		{
+			const __m128i zero = _mm_setzero_si128();
+			return _mm_packus_epi16( Channels16( _mm_unpacklo_epi8( d,zero ),_mm_unpacklo_epi8( s,zero ) ),
+				Channels16( _mm_unpackhi_epi8( d,zero ),_mm_unpackhi_epi8( s,zero ) ) );
+		}
+	private:
+		// packus does the clamping (lanes are signed 16-bit here)
+		__m128i Channels16( __m128i d16,__m128i s16 ) const
+		{
+			const __m128i alpha16 = Detail::AlphaOf16( s16 );
+			const __m128i calpha16 = _mm_sub_epi16( _mm_set1_epi16( 0x00FF ),alpha16 );
+			return _mm_add_epi16( Detail::Mul255( d16,calpha16 ),mode.BlendPremultiplied( d16,s16,alpha16 ) );
+		}
+	private:
+		Mode mode;
+	};
+
+	// one row (or one contiguous run) of pixels through a mode
+	template< class Mode,class Isa >
+	struct Row;
+
+	template< class Mode >
+	struct Row< Mode,Scalar >
+	{
+		static void Run( Color* pDst,const Color* pSrc,unsigned int nPixels,const Mode& mode )
+		{
+			for( Color* end = pDst + nPixels; pDst < end; pDst++,pSrc++ )
+			{
+				*pDst = mode.Blend( *pDst,*pSrc );
+			}
+		}
+	};
+
+	template< class Mode >
+	struct Row< Mode,SSE2 >
+	{
+		// rect blits start at arbitrary x, so loads and stores are unaligned
+		static void Run( Color* pDst,const Color* pSrc,unsigned int nPixels,const Mode& mode )
+		{
+			for( Color* end = pDst + ( nPixels & ~3u ); pDst < end; pDst += 4,pSrc += 4 )
+			{
+				const __m128i d = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pDst ) );
+				const __m128i s = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc ) );
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( pDst ),mode.Blend( d,s ) );
+			}
+			Row< Mode,Scalar >::Run( pDst,pSrc,nPixels & 3u,mode );
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	PixelSurface.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include "Rect.h"
+#include "Surface.h"
+#include "PixelFormat.h"
+#include <algorithm>
+#include <type_traits>
+
+// a Surface-like buffer stored in any PixelFormat, for secondary buffers that don't need
+// 32 bits per pixel (masks and glyph coverage in A8, lightmaps in L8, opaque art in RGB565)
+// pixels reach the 32-bit world through the Unpack / Pack / Coverage kernels of
+// PixelFormat.h; the default format is the same ARGB8888 layout Surface uses
+template< class Format = PixelFormat::ARGB8888 >
+class PixelSurface
+{
+public:
+	typedef typename Format::Type Type;
+public:
+	PixelSurface( unsigned int width,unsigned int height,
+		unsigned int byteAlignment = DEFAULT_SURFACE_ALIGNMENT )
+		:
+		buffer( nullptr ),
+		width( width ),
+		height( height ),
+		pixelPitch( CalculatePixelPitch( width,byteAlignment ) )
+	{
+		buffer = new Type[height * pixelPitch];
+	}
+	PixelSurface( PixelSurface&& source )
+		:
+		buffer( source.buffer ),
+		width( source.width ),
+		height( source.height ),
+		pixelPitch( source.pixelPitch )
+	{
+		source.buffer = nullptr;
+	}
+	PixelSurface( const PixelSurface& src )
+		:
+		buffer( nullptr ),
+		width( src.width ),
+		height( src.height ),
+		pixelPitch( src.pixelPitch )
+	{
+		buffer = new Type[height * pixelPitch];
+		memcpy( buffer,src.buffer,GetPitch() * height );
+	}
+	// packs an ARGB surface into this format
+	explicit PixelSurface( const Surface& src )
+		:
+		PixelSurface( src.GetWidth(),src.GetHeight() )
+	{
+		ConvertFrom( src );
+	}
+	PixelSurface& operator=( PixelSurface&& donor )
+	{
+		delete[] buffer;
+		width = donor.width;
+		height = donor.height;
+		pixelPitch = donor.pixelPitch;
+		buffer = donor.buffer;
+		donor.buffer = nullptr;
+		return *this;
+	}
+	PixelSurface& operator=( const PixelSurface& ) = delete;
+	~PixelSurface()
+	{
+		if( buffer != nullptr )
+		{
+			delete[] buffer;
+			buffer = nullptr;
+		}
+	}
+	inline void PutPixel( unsigned int x,unsigned int y,Type p )
+	{
+		assert( x < width );
+		assert( y < height );
+		buffer[y * pixelPitch + x] = p;
+	}
+	inline Type GetPixel( unsigned int x,unsigned int y ) const
+	{
+		assert( x < width );
+		assert( y < height );
+		return buffer[y * pixelPitch + x];
+	}
+	inline unsigned int GetWidth() const
+	{
+		return width;
+	}
+	inline unsigned int GetHeight() const
+	{
+		return height;
+	}
+	inline unsigned int GetPitch() const
+	{
+		return pixelPitch * sizeof( Type );
+	}
+	inline unsigned int GetPixelPitch() const
+	{
+		return pixelPitch;
+	}
+	inline Type* const GetBuffer()
+	{
+		return buffer;
+	}
+	inline const Type* const GetBufferConst() const
+	{
+		return buffer;
+	}
+	void Fill( Type p )
+	{
+		PROFILE_FUNCTION();
+		std::fill( buffer,buffer + height * pixelPitch,p );
+	}
+	void Clear()
+	{
+		PROFILE_FUNCTION();
+		memset( buffer,0,GetPitch() * height );
+	}
+	// src must be the same size; converts every pixel to this format
+	template< class Isa = Pixel::SSE2 >
+	void ConvertFrom( const Surface& src )
+	{
+		PROFILE_FUNCTION();
+		assert( src.GetWidth() == width );
+		assert( src.GetHeight() == height );
+		for( unsigned int y = 0; y < height; y++ )
+		{
+			PixelFormat::Pack< Format,Isa >::Run( &buffer[y * pixelPitch],
+				&src.GetBufferConst()[y * src.GetPixelPitch()],width );
+		}
+	}
+	// expands srcRect to ARGB with its top left at dstPt (no clipping, overwrites dst)
+	template< class Isa = Pixel::SSE2 >
+	void Blt( Vei2 dstPt,const RectI& srcRect,Surface& dst ) const
+	{
+		PROFILE_FUNCTION();
+		assert( dstPt.x >= 0 && dstPt.x + srcRect.GetWidth() <= (int)dst.GetWidth() );
+		assert( dstPt.y >= 0 && dstPt.y + srcRect.GetHeight() <= (int)dst.GetHeight() );
+		Color* const pDst = dst.GetBuffer();
+		const unsigned int dstPitch = dst.GetPixelPitch();
+		for( int y = 0; y < srcRect.GetHeight(); y++ )
+		{
+			PixelFormat::Unpack< Format,Isa >::Run( &pDst[( dstPt.y + y ) * dstPitch + dstPt.x],
+				&buffer[( srcRect.top + y ) * pixelPitch + srcRect.left],srcRect.GetWidth() );
+		}
+	}
+	// expands the whole surface into dst, which must be the same size
+	template< class Isa = Pixel::SSE2 >
+	void ConvertTo( Surface& dst ) const
+	{
+		assert( dst.GetWidth() == width );
+		assert( dst.GetHeight() == height );
+		Blt< Isa >( { 0,0 },RectI( 0,(int)width,0,(int)height ),dst );
+	}
+	// A8 only: blends c into dst wherever srcRect has coverage (mask and glyph drawing)
+	template< class Isa = Pixel::SSE2 >
+	void BltCoverage( Vei2 dstPt,const RectI& srcRect,Surface& dst,Color c ) const
+	{
+		static_assert( std::is_same< Format,PixelFormat::A8 >::value,
+			"BltCoverage needs an A8 surface" );
+		PROFILE_FUNCTION();
+		assert( dstPt.x >= 0 && dstPt.x + srcRect.GetWidth() <= (int)dst.GetWidth() );
+		assert( dstPt.y >= 0 && dstPt.y + srcRect.GetHeight() <= (int)dst.GetHeight() );
+		Color* const pDst = dst.GetBuffer();
+		const unsigned int dstPitch = dst.GetPixelPitch();
+		for( int y = 0; y < srcRect.GetHeight(); y++ )
+		{
+			PixelFormat::Coverage< Isa >::Run( &pDst[( dstPt.y + y ) * dstPitch + dstPt.x],
+				&buffer[( srcRect.top + y ) * pixelPitch + srcRect.left],srcRect.GetWidth(),c );
+		}
+	}
+private:
+	static unsigned int CalculatePixelPitch( unsigned int width,unsigned int byteAlignment )
+	{
+		assert( byteAlignment % sizeof( Type ) == 0 );
+		const unsigned int pixelAlignment = byteAlignment / sizeof( Type );
+		return width + ( pixelAlignment - width % pixelAlignment ) % pixelAlignment;
+	}
+protected:
+	Type* buffer;
+	unsigned int width;
+	unsigned int height;
+	unsigned int pixelPitch;
+};
+
+typedef PixelSurface< PixelFormat::A8 > SurfaceA8;
+typedef PixelSurface< PixelFormat::L8 > SurfaceL8;
+typedef PixelSurface< PixelFormat::RGB565 > SurfaceRGB565;
\ No newline at end of file
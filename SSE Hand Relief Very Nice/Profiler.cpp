@@ -0,0 +1,109 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	Profiler.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "Profiler.h"
+#include <Windows.h>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	std::mutex registryMutex;
+	std::vector< std::unique_ptr< Profiler::ThreadBuffer > > registry;
+	// VS2013 has no thread_local, and a plain pointer is all we need anyway
+	__declspec( thread ) Profiler::ThreadBuffer* pThreadBuffer = nullptr;
+}
+
+Profiler::ThreadBuffer::ThreadBuffer( unsigned int threadId )
+	:
+	count( 0 ),
+	depth( 0 ),
+	threadId( threadId )
+{}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+	if( pThreadBuffer == nullptr )
+	{
+		// buffers outlive their threads so zones of finished threads still get dumped
+		std::lock_guard<std::mutex> lock( registryMutex );
+		registry.push_back( std::unique_ptr< ThreadBuffer >( new ThreadBuffer( GetCurrentThreadId() ) ) );
+		pThreadBuffer = registry.back().get();
+	}
+	return *pThreadBuffer;
+}
+
+unsigned long long Profiler::GetTicks()
+{
+	unsigned long long count;
+	QueryPerformanceCounter( (LARGE_INTEGER*)&count );
+	return count;
+}
+
+bool Profiler::Dump( const std::wstring& filename )
+{
+	std::ofstream file( filename.c_str() );
+	if( !file )
+	{
+		return false;
+	}
+
+	unsigned long long frequency;
+	QueryPerformanceFrequency( (LARGE_INTEGER*)&frequency );
+	const double microPerTick = 1000000.0 / (double)frequency;
+
+	std::lock_guard<std::mutex> lock( registryMutex );
+
+	// timestamps relative to the earliest zone still in any buffer
+	unsigned long long base = ~0ull;
+	for( auto& pBuf : registry )
+	{
+		const unsigned int n = pBuf->count.load( std::memory_order_acquire );
+		const unsigned int first = n > ThreadBuffer::capacity ? n - ThreadBuffer::capacity : 0;
+		for( unsigned int i = first; i < n; i++ )
+		{
+			base = min( base,pBuf->zones[i & ( ThreadBuffer::capacity - 1 )].start );
+		}
+	}
+
+	file << std::fixed << std::setprecision( 3 ) << "{\"traceEvents\":[\n";
+	bool firstEvent = true;
+	for( auto& pBuf : registry )
+	{
+		const unsigned int n = pBuf->count.load( std::memory_order_acquire );
+		const unsigned int first = n > ThreadBuffer::capacity ? n - ThreadBuffer::capacity : 0;
+		for( unsigned int i = first; i < n; i++ )
+		{
+			const Zone& z = pBuf->zones[i & ( ThreadBuffer::capacity - 1 )];
+			// zone names come from string literals / __FUNCTION__, no escaping needed
+			file << ( firstEvent ? "" : ",\n" )
+				<< "{\"name\":\"" << z.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << pBuf->threadId
+				<< ",\"ts\":" << (double)( z.start - base ) * microPerTick
+				<< ",\"dur\":" << (double)( z.end - z.start ) * microPerTick
+				<< ",\"args\":{\"depth\":" << z.depth << "}}";
+			firstEvent = false;
+		}
+	}
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return bool( file );
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	Profiler.h																			  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <string>
+
+// scoped CPU profiling zones, dumped as a Chrome trace (chrome://tracing or ui.perfetto.dev)
+// zones only exist when CHILI_PROFILE is defined, otherwise the macros expand to nothing
+//
+//	void Foo()
+//	{
+//		PROFILE_FUNCTION();
+//		...
+//		{
+//			PROFILE_ZONE( "Foo inner loop" );
+//			...
+//		}
+//	}
+#ifdef CHILI_PROFILE
+#define PROFILE_CONCAT_INNER( a,b ) a##b
+#define PROFILE_CONCAT( a,b ) PROFILE_CONCAT_INNER( a,b )
+#define PROFILE_ZONE( name ) ProfileZone PROFILE_CONCAT( profileZone,__LINE__ )( name )
+#define PROFILE_FUNCTION() PROFILE_ZONE( __FUNCTION__ )
+#define PROFILE_DUMP( filename ) Profiler::Dump( filename )
+#else
+#define PROFILE_ZONE( name )
+#define PROFILE_FUNCTION()
+#define PROFILE_DUMP( filename )
+#endif
+
+class Profiler
+{
+public:
+	struct Zone
+	{
+		const char* name;
+		unsigned long long start;
+		unsigned long long end;
+		unsigned int depth;
+	};
+	// zones of one thread; only that thread writes, so recording needs no locks
+	// the buffer is a ring, once full the oldest zones are overwritten
+	class ThreadBuffer
+	{
+		friend class Profiler;
+	public:
+		ThreadBuffer( unsigned int threadId );
+		ThreadBuffer( const ThreadBuffer& ) = delete;
+		ThreadBuffer& operator=( const ThreadBuffer& ) = delete;
+		unsigned int Enter()
+		{
+			return depth++;
+		}
+		void Leave( const char* name,unsigned long long start,unsigned long long end,unsigned int zoneDepth )
+		{
+			const unsigned int n = count.load( std::memory_order_relaxed );
+			Zone& z = zones[n & ( capacity - 1 )];
+			z.name = name;
+			z.start = start;
+			z.end = end;
+			z.depth = zoneDepth;
+			count.store( n + 1,std::memory_order_release );
+			depth--;
+		}
+	private:
+		static const unsigned int capacity = 1 << 16;
+		Zone zones[capacity];
+		std::atomic<unsigned int> count;
+		unsigned int depth;
+		const unsigned int threadId;
+	};
+public:
+	// buffer of the calling thread (created and registered on first use)
+	static ThreadBuffer& GetThreadBuffer();
+	static unsigned long long GetTicks();
+	// writes every registered thread's zones as Chrome trace event JSON
+	static bool Dump( const std::wstring& filename );
+};
+
+class ProfileZone
+{
+public:
+	ProfileZone( const char* name )
+		:
+		name( name ),
+		buffer( Profiler::GetThreadBuffer() ),
+		depth( buffer.Enter() ),
+		start( Profiler::GetTicks() )
+	{}
+	~ProfileZone()
+	{
+		buffer.Leave( name,start,Profiler::GetTicks(),depth );
+	}
+	ProfileZone( const ProfileZone& ) = delete;
+	ProfileZone& operator=( const ProfileZone& ) = delete;
+private:
+	const char* const name;
+	Profiler::ThreadBuffer& buffer;
+	const unsigned int depth;
+	const unsigned long long start;
+};
\ No newline at end of file
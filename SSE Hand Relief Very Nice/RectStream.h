@@ -0,0 +1,180 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	RectStream.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2Stream.h"
+#include "Rect.h"
+
+// structure-of-arrays batch of float rects for broadphase tests
+// the batch queries write a bitmask, bit i of word i / 32 set when rect i passes;
+// the mask must hold MaskWords() words
+class RectStream
+{
+public:
+	RectStream( unsigned int capacity = 0 )
+		:
+		left( nullptr ),
+		right( nullptr ),
+		top( nullptr ),
+		bottom( nullptr ),
+		size( 0 ),
+		capacity( 0 )
+	{
+		Reserve( capacity );
+	}
+	RectStream( const RectStream& ) = delete;
+	RectStream& operator=( const RectStream& ) = delete;
+	~RectStream()
+	{
+		_mm_free( left );
+		_mm_free( right );
+		_mm_free( top );
+		_mm_free( bottom );
+	}
+	void Reserve( unsigned int n )
+	{
+		// rounded to whole mask words so the queries never read past the arrays
+		n = ( n + 31 ) & ~31u;
+		if( n > capacity )
+		{
+			left = StreamDetail::Grow( left,size,n );
+			right = StreamDetail::Grow( right,size,n );
+			top = StreamDetail::Grow( top,size,n );
+			bottom = StreamDetail::Grow( bottom,size,n );
+			capacity = n;
+		}
+	}
+	void Push( const RectF& r )
+	{
+		if( size == capacity )
+		{
+			Reserve( capacity != 0 ? capacity * 2 : 32 );
+		}
+		left[size] = r.left;
+		right[size] = r.right;
+		top[size] = r.top;
+		bottom[size] = r.bottom;
+		size++;
+	}
+	inline RectF Get( unsigned int i ) const
+	{
+		assert( i < size );
+		return RectF( left[i],right[i],top[i],bottom[i] );
+	}
+	inline void Set( unsigned int i,const RectF& r )
+	{
+		assert( i < size );
+		left[i] = r.left;
+		right[i] = r.right;
+		top[i] = r.top;
+		bottom[i] = r.bottom;
+	}
+	inline unsigned int Size() const
+	{
+		return size;
+	}
+	inline unsigned int MaskWords() const
+	{
+		return ( size + 31 ) / 32;
+	}
+	void Clear()
+	{
+		size = 0;
+	}
+	void Translate( Vec2 d )
+	{
+		const __m128 dx = _mm_set1_ps( d.x );
+		const __m128 dy = _mm_set1_ps( d.y );
+		for( unsigned int i = 0; i < size; i += 4 )
+		{
+			_mm_store_ps( left + i,_mm_add_ps( _mm_load_ps( left + i ),dx ) );
+			_mm_store_ps( right + i,_mm_add_ps( _mm_load_ps( right + i ),dx ) );
+			_mm_store_ps( top + i,_mm_add_ps( _mm_load_ps( top + i ),dy ) );
+			_mm_store_ps( bottom + i,_mm_add_ps( _mm_load_ps( bottom + i ),dy ) );
+		}
+	}
+	// same test as _Rect::Overlaps for every rect; returns the number of hits
+	unsigned int Overlaps( const RectF& r,unsigned int* mask ) const
+	{
+		const __m128 rLeft = _mm_set1_ps( r.left );
+		const __m128 rRight = _mm_set1_ps( r.right );
+		const __m128 rTop = _mm_set1_ps( r.top );
+		const __m128 rBottom = _mm_set1_ps( r.bottom );
+		return Query( mask,[&]( unsigned int i )
+		{
+			const __m128 hit = _mm_and_ps(
+				_mm_and_ps( _mm_cmplt_ps( _mm_load_ps( top + i ),rBottom ),
+					_mm_cmpgt_ps( _mm_load_ps( bottom + i ),rTop ) ),
+				_mm_and_ps( _mm_cmplt_ps( _mm_load_ps( left + i ),rRight ),
+					_mm_cmpgt_ps( _mm_load_ps( right + i ),rLeft ) ) );
+			return _mm_movemask_ps( hit );
+		} );
+	}
+	// same test as _Rect::Contains (edges inclusive); returns the number of hits
+	unsigned int Contains( Vec2 p,unsigned int* mask ) const
+	{
+		const __m128 px = _mm_set1_ps( p.x );
+		const __m128 py = _mm_set1_ps( p.y );
+		return Query( mask,[&]( unsigned int i )
+		{
+			const __m128 hit = _mm_and_ps(
+				_mm_and_ps( _mm_cmple_ps( _mm_load_ps( top + i ),py ),
+					_mm_cmpge_ps( _mm_load_ps( bottom + i ),py ) ),
+				_mm_and_ps( _mm_cmple_ps( _mm_load_ps( left + i ),px ),
+					_mm_cmpge_ps( _mm_load_ps( right + i ),px ) ) );
+			return _mm_movemask_ps( hit );
+		} );
+	}
+private:
+	// test4( i ) returns the 4-bit movemask for rects i..i+3
+	template< class Test >
+	unsigned int Query( unsigned int* mask,Test test4 ) const
+	{
+		unsigned int nHits = 0;
+		for( unsigned int word = 0,nWords = MaskWords(); word < nWords; word++ )
+		{
+			unsigned int bits = 0;
+			for( unsigned int group = 0; group < 8; group++ )
+			{
+				bits |= (unsigned int)test4( word * 32 + group * 4 ) << ( group * 4 );
+			}
+			// drop the padding rects in the last word
+			const unsigned int nValid = size - word * 32;
+			if( nValid < 32 )
+			{
+				bits &= ( 1u << nValid ) - 1;
+			}
+			mask[word] = bits;
+			for( unsigned int b = bits; b != 0; b &= b - 1 )
+			{
+				nHits++;
+			}
+		}
+		return nHits;
+	}
+private:
+	float* left;
+	float* right;
+	float* top;
+	float* bottom;
+	unsigned int size;
+	unsigned int capacity;
+};
\ No newline at end of file
@@ -0,0 +1,130 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	RleSprite.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "RleSprite.h"
+#include "Surface.h"
+#include "Profiler.h"
+#include <string.h>
+#include <assert.h>
+
+RleSprite::RleSprite( const Surface& src,const RectI& srcRect )
+{
+	Encode( src,srcRect,[]( Color c )
+	{
+		return c.x == 0 ? Skip : c.x == 255 ? Opaque : Translucent;
+	} );
+}
+
+RleSprite::RleSprite( const Surface& src,const RectI& srcRect,Color key )
+{
+	Encode( src,srcRect,[key]( Color c )
+	{
+		return c == key ? Skip : Opaque;
+	} );
+}
+
+template< class Classify >
+void RleSprite::Encode( const Surface& src,const RectI& srcRect,Classify classify )
+{
+	width = srcRect.GetWidth();
+	height = srcRect.GetHeight();
+	assert( width <= 0xFFFF );
+	rowStart.reserve( height + 1 );
+	for( int y = 0; y < height; y++ )
+	{
+		rowStart.push_back( (unsigned int)spans.size() );
+		int x = 0;
+		while( x < width )
+		{
+			const SpanType type = classify( src.GetPixel( srcRect.left + x,srcRect.top + y ) );
+			int end = x + 1;
+			while( end < width && classify( src.GetPixel( srcRect.left + end,srcRect.top + y ) ) == type )
+			{
+				end++;
+			}
+			if( type != Skip )
+			{
+				Span span;
+				span.x = (unsigned short)x;
+				span.length = (unsigned short)( end - x );
+				span.type = type;
+				span.pixelOffset = (unsigned int)pixels.size();
+				spans.push_back( span );
+				for( int i = x; i < end; i++ )
+				{
+					pixels.push_back( src.GetPixel( srcRect.left + i,srcRect.top + y ) );
+				}
+			}
+			x = end;
+		}
+	}
+	rowStart.push_back( (unsigned int)spans.size() );
+}
+
+void RleSprite::Draw( Vei2 dstPt,Surface& target ) const
+{
+	PROFILE_FUNCTION();
+	const int clipLeft = max( -dstPt.x,0 );
+	const int clipRight = min( width,(int)target.GetWidth() - dstPt.x );
+	const int clipTop = max( -dstPt.y,0 );
+	const int clipBottom = min( height,(int)target.GetHeight() - dstPt.y );
+	const int pitch = (int)target.GetPixelPitch();
+	Color* const pBuffer = target.GetBuffer();
+	const Pixel::PerPixelAlpha alphaMode;
+	for( int y = clipTop; y < clipBottom; y++ )
+	{
+		Color* const pRow = &pBuffer[( dstPt.y + y ) * pitch];
+		for( unsigned int i = rowStart[y]; i < rowStart[y + 1]; i++ )
+		{
+			const Span& span = spans[i];
+			const int x0 = max( (int)span.x,clipLeft );
+			const int x1 = min( (int)span.x + (int)span.length,clipRight );
+			if( x0 >= x1 )
+			{
+				continue;
+			}
+			Color* const pDst = pRow + dstPt.x + x0;
+			const Color* const pSrc = &pixels[span.pixelOffset + x0 - span.x];
+			if( span.type == Opaque )
+			{
+				memcpy( pDst,pSrc,( x1 - x0 ) * sizeof( Color ) );
+			}
+			else
+			{
+				Pixel::Row< Pixel::PerPixelAlpha,Pixel::SSE2 >::Run( pDst,pSrc,x1 - x0,alphaMode );
+			}
+		}
+	}
+}
+
+int RleSprite::GetWidth() const
+{
+	return width;
+}
+
+int RleSprite::GetHeight() const
+{
+	return height;
+}
+
+unsigned int RleSprite::GetSpanCount() const
+{
+	return (unsigned int)spans.size();
+}
\ No newline at end of file
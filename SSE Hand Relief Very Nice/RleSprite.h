@@ -0,0 +1,71 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	RleSprite.h																			  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include "Rect.h"
+#include "Colors.h"
+#include <vector>
+
+class Surface;
+
+// sprite preprocessed into per-row spans so drawing only touches visible pixels:
+// fully transparent runs are skipped outright, opaque runs are bulk copied and only
+// translucent runs (alpha 1..254) go through the per-pixel alpha blend
+class RleSprite
+{
+public:
+	// classify by alpha: 0 skipped, 255 copied, anything else blended
+	RleSprite( const Surface& src,const RectI& srcRect );
+	// classify by colour key: key pixels skipped, everything else copied
+	RleSprite( const Surface& src,const RectI& srcRect,Color key );
+	// clipped against the target
+	void Draw( Vei2 dstPt,Surface& target ) const;
+	int GetWidth() const;
+	int GetHeight() const;
+	unsigned int GetSpanCount() const;
+private:
+	enum SpanType : unsigned char
+	{
+		Skip,
+		Opaque,
+		Translucent
+	};
+	// skipped runs aren't stored, the gap between spans' x is the skip
+	struct Span
+	{
+		unsigned short x;
+		unsigned short length;
+		SpanType type;
+		// index of the span's first pixel in pixels
+		unsigned int pixelOffset;
+	};
+private:
+	template< class Classify >
+	void Encode( const Surface& src,const RectI& srcRect,Classify classify );
+private:
+	int width;
+	int height;
+	std::vector<Span> spans;
+	// spans of row y are [rowStart[y],rowStart[y + 1])
+	std::vector<unsigned int> rowStart;
+	std::vector<Color> pixels;
+};
\ No newline at end of file
@@ -0,0 +1,380 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	Roofline.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "Roofline.h"
+#include "Vec2.h"
+#include "Rect.h"
+#include "Surface.h"
+#include "Timer.h"
+#include "PerfCounters.h"
+#include <float.h>
+#include <functional>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <emmintrin.h>
+
+namespace
+{
+	// keeps the read kernels from being optimized away
+	volatile int sink;
+
+	float SecondsOf( const Timer& timer )
+	{
+		return (float)( (double)timer.GetTicks() / (double)timer.GetFrequency() );
+	}
+
+	// best time in seconds over nReps runs of f
+	float BestOf( int nReps,const std::function<void()>& f )
+	{
+		Timer timer;
+		float best = FLT_MAX;
+		for( int i = 0; i < nReps; i++ )
+		{
+			timer.StartWatch();
+			f();
+			timer.StopWatch();
+			best = min( best,SecondsOf( timer ) );
+		}
+		return best;
+	}
+
+	void ReadKernel( const __m128i* p,size_t n )
+	{
+		__m128i acc0 = _mm_setzero_si128();
+		__m128i acc1 = _mm_setzero_si128();
+		__m128i acc2 = _mm_setzero_si128();
+		__m128i acc3 = _mm_setzero_si128();
+		for( const __m128i* end = p + n; p < end; p += 4 )
+		{
+			acc0 = _mm_add_epi32( acc0,_mm_load_si128( p ) );
+			acc1 = _mm_add_epi32( acc1,_mm_load_si128( p + 1 ) );
+			acc2 = _mm_add_epi32( acc2,_mm_load_si128( p + 2 ) );
+			acc3 = _mm_add_epi32( acc3,_mm_load_si128( p + 3 ) );
+		}
+		const __m128i acc = _mm_add_epi32( _mm_add_epi32( acc0,acc1 ),_mm_add_epi32( acc2,acc3 ) );
+		sink = _mm_cvtsi128_si32( acc );
+	}
+
+	void WriteKernel( __m128i* p,size_t n,bool nonTemporal )
+	{
+		const __m128i val = _mm_set1_epi32( 0x7F7F7F7F );
+		if( nonTemporal )
+		{
+			for( __m128i* end = p + n; p < end; p++ )
+			{
+				_mm_stream_si128( p,val );
+			}
+			_mm_sfence();
+		}
+		else
+		{
+			for( __m128i* end = p + n; p < end; p++ )
+			{
+				_mm_store_si128( p,val );
+			}
+		}
+	}
+
+	void CopyKernel( __m128i* pDst,const __m128i* pSrc,size_t n,bool nonTemporal )
+	{
+		if( nonTemporal )
+		{
+			for( __m128i* end = pDst + n; pDst < end; pDst++,pSrc++ )
+			{
+				_mm_stream_si128( pDst,_mm_load_si128( pSrc ) );
+			}
+			_mm_sfence();
+		}
+		else
+		{
+			for( __m128i* end = pDst + n; pDst < end; pDst++,pSrc++ )
+			{
+				_mm_store_si128( pDst,_mm_load_si128( pSrc ) );
+			}
+		}
+	}
+
+	// six independent multiply-add chains (x86 only has 8 xmm registers)
+	// each iteration is 12 instructions of 8 lanes = 96 lane ops
+	void ComputeKernel( unsigned int nIterations )
+	{
+		const __m128i m = _mm_set1_epi16( 3 );
+		__m128i a0 = _mm_set1_epi16( 1 );
+		__m128i a1 = _mm_set1_epi16( 2 );
+		__m128i a2 = _mm_set1_epi16( 3 );
+		__m128i a3 = _mm_set1_epi16( 4 );
+		__m128i a4 = _mm_set1_epi16( 5 );
+		__m128i a5 = _mm_set1_epi16( 6 );
+		for( unsigned int i = 0; i < nIterations; i++ )
+		{
+			a0 = _mm_add_epi16( _mm_mullo_epi16( a0,m ),m );
+			a1 = _mm_add_epi16( _mm_mullo_epi16( a1,m ),m );
+			a2 = _mm_add_epi16( _mm_mullo_epi16( a2,m ),m );
+			a3 = _mm_add_epi16( _mm_mullo_epi16( a3,m ),m );
+			a4 = _mm_add_epi16( _mm_mullo_epi16( a4,m ),m );
+			a5 = _mm_add_epi16( _mm_mullo_epi16( a5,m ),m );
+		}
+		const __m128i acc = _mm_add_epi16( _mm_add_epi16( _mm_add_epi16( a0,a1 ),_mm_add_epi16( a2,a3 ) ),
+			_mm_add_epi16( a4,a5 ) );
+		sink = _mm_cvtsi128_si32( acc );
+	}
+
+	struct Kernel
+	{
+		std::wstring name;
+		// bytes read + written per pixel
+		float bytesPerPixel;
+		// arithmetic 16-bit lane ops per pixel (unpack / pack / loads not counted)
+		float opsPerPixel;
+		bool writeOnly;
+		std::function<void()> run;
+	};
+
+	// translucent premultiplied source through PremultipliedAlpha< Subtractive >, the case the
+	// opaque sources of most callers hide: a subtractive source can only take away from the
+	// part of dst it covers, so no channel may fall below dst * ( 255 - a ) / 255, and the
+	// SSE2 kernel must match the scalar one; returns an empty string when both hold
+	std::wstring CheckPremultipliedSubtractive( const Surface& src )
+	{
+		typedef Pixel::PremultipliedAlpha< Pixel::Subtractive > Mode;
+		Surface premultiplied( src );
+		premultiplied.PremultiplyAlpha();
+		// opaque dst of the inverted colours, so sources brighter than dst occur everywhere
+		Surface dst( src.GetWidth(),src.GetHeight() );
+		for( unsigned int y = 0; y < dst.GetHeight(); y++ )
+		{
+			for( unsigned int x = 0; x < dst.GetWidth(); x++ )
+			{
+				const Color c = src.GetPixel( x,y );
+				dst.PutPixel( x,y,Color( 255,255 - c.r,255 - c.g,255 - c.b ) );
+			}
+		}
+		Surface scalar( dst );
+		Surface sse( dst );
+		scalar.Compose< Mode,Pixel::Scalar >( premultiplied );
+		sse.Compose< Mode,Pixel::SSE2 >( premultiplied );
+		for( unsigned int y = 0; y < dst.GetHeight(); y++ )
+		{
+			for( unsigned int x = 0; x < dst.GetWidth(); x++ )
+			{
+				const Color d = dst.GetPixel( x,y );
+				const Color r = scalar.GetPixel( x,y );
+				const unsigned int keep = 255 - premultiplied.GetPixel( x,y ).x;
+				const bool kept = r.r >= d.r * keep / 255 && r.g >= d.g * keep / 255 && r.b >= d.b * keep / 255;
+				if( !kept || sse.GetPixel( x,y ) != r )
+				{
+					std::wstringstream ss;
+					ss << L"Compose<PremultipliedAlpha<Subtractive>> " << ( kept ? L"SSE2 != Scalar" : L"eats into dst" )
+						<< L" at (" << x << L"," << y << L")";
+					return ss.str();
+				}
+			}
+		}
+		return std::wstring();
+	}
+
+	std::wstring Bar( float fraction )
+	{
+		const int nChars = 40;
+		const int n = (int)( min( fraction,1.0f ) * (float)nChars + 0.5f );
+		return std::wstring( n,L'#' ) + std::wstring( nChars - n,L'.' );
+	}
+}
+
+Roofline::Roofline( unsigned int width,unsigned int height )
+	:
+	width( width ),
+	height( height )
+{}
+
+Roofline::Roof Roofline::Calibrate( size_t workingSetBytes ) const
+{
+	// split the working set over a source and a destination buffer
+	const size_t n = ( workingSetBytes / 2 / sizeof( __m128i ) ) & ~size_t( 3 );
+	const size_t bytes = n * sizeof( __m128i );
+	__m128i* const pSrc = (__m128i*)_mm_malloc( bytes,64 );
+	__m128i* const pDst = (__m128i*)_mm_malloc( bytes,64 );
+	// touch everything once so page faults stay out of the timings
+	WriteKernel( pSrc,n,false );
+	WriteKernel( pDst,n,false );
+
+	Roof roof;
+	roof.readBandwidth = (float)bytes / BestOf( nReps,[=](){ ReadKernel( pSrc,n ); } ) / 1e9f;
+	roof.writeBandwidth = (float)bytes / min(
+		BestOf( nReps,[=](){ WriteKernel( pDst,n,false ); } ),
+		BestOf( nReps,[=](){ WriteKernel( pDst,n,true ); } ) ) / 1e9f;
+	roof.copyBandwidth = (float)( bytes * 2 ) / min(
+		BestOf( nReps,[=](){ CopyKernel( pDst,pSrc,n,false ); } ),
+		BestOf( nReps,[=](){ CopyKernel( pDst,pSrc,n,true ); } ) ) / 1e9f;
+
+	const unsigned int nIterations = 1 << 24;
+	roof.laneOpsPerSec = (float)nIterations * 96.0f /
+		BestOf( nReps,[=](){ ComputeKernel( nIterations ); } ) / 1e9f;
+
+	_mm_free( pSrc );
+	_mm_free( pDst );
+	return roof;
+}
+
+void Roofline::Run( std::wostream& report ) const
+{
+	Surface dst( width,height );
+	Surface src( width,height );
+	// translucent gradient so the alpha kernels have real work to do
+	for( unsigned int y = 0; y < height; y++ )
+	{
+		for( unsigned int x = 0; x < width; x++ )
+		{
+			src.PutPixel( x,y,Color( (unsigned char)( x + y ),(unsigned char)x,(unsigned char)y,
+				(unsigned char)( x ^ y ) ) );
+		}
+	}
+	dst.Copy( src );
+	// sprite-like source: an opaque disc with a translucent rim on a transparent background,
+	// once without and once with opacity tiles so the tile skipping shows up side by side
+	Surface sprite( width,height );
+	const int cx = (int)width / 2;
+	const int cy = (int)height / 2;
+	const int radius = (int)min( width,height ) / 3;
+	for( unsigned int y = 0; y < height; y++ )
+	{
+		for( unsigned int x = 0; x < width; x++ )
+		{
+			const int dx = (int)x - cx;
+			const int dy = (int)y - cy;
+			const int r2 = dx * dx + dy * dy;
+			const unsigned char a = r2 <= radius * radius ? 255 :
+				r2 <= ( radius + 8 ) * ( radius + 8 ) ? 128 : 0;
+			sprite.PutPixel( x,y,Color( a,(unsigned char)x,(unsigned char)y,(unsigned char)( x + y ) ) );
+		}
+	}
+	Surface spriteTiled( sprite );
+	spriteTiled.EnableOpacityTiles();
+	RectI srcRect( 0,(int)width,0,(int)height );
+	const Vei2 origin = { 0,0 };
+	Surface* const pDst = &dst;
+	Surface* const pSrc = &src;
+	Surface* const pSprite = &sprite;
+	Surface* const pSpriteTiled = &spriteTiled;
+
+	// bytes / ops per pixel are the kernels' own memory traffic and channel arithmetic
+	const Kernel kernels[] =
+	{
+		{ L"Clear",4.0f,0.0f,true,[=](){ pDst->Clear(); } },
+		{ L"ClearSSE",4.0f,0.0f,true,[=](){ pDst->ClearSSE(); } },
+		{ L"Fill",4.0f,0.0f,true,[=](){ pDst->Fill( GRAY ); } },
+		{ L"FillSSE",4.0f,0.0f,true,[=](){ pDst->FillSSE( GRAY ); } },
+		{ L"Copy",8.0f,0.0f,false,[=](){ pDst->Copy( *pSrc ); } },
+		{ L"Fade",8.0f,6.0f,false,[=](){ pDst->Fade( 200 ); } },
+		{ L"FadeSSE",8.0f,8.0f,false,[=](){ pDst->FadeSSE( 200 ); } },
+		{ L"FadeHalfSSE",8.0f,4.0f,false,[=](){ pDst->FadeHalfSSE(); } },
+		{ L"Tint",8.0f,12.0f,false,[=](){ pDst->Tint( Color( 100,GREEN ) ); } },
+		{ L"TintSSE",8.0f,16.0f,false,[=](){ pDst->TintSSE( Color( 100,GREEN ) ); } },
+		{ L"TintPrecomputedSSE",8.0f,12.0f,false,[=](){ pDst->TintPrecomputedSSE( Color( 100,GREEN ) ); } },
+		{ L"Blend",12.0f,16.0f,false,[=](){ pDst->Blend( *pSrc,100 ); } },
+		{ L"BlendHalfPacked",12.0f,3.0f,false,[=](){ pDst->BlendHalfPacked( *pSrc ); } },
+		{ L"BlendAlpha",12.0f,17.0f,false,[=](){ pDst->BlendAlpha( *pSrc ); } },
+		{ L"BlendAlphaPremultipliedPacked",12.0f,13.0f,false,[=](){ pDst->BlendAlphaPremultipliedPacked( *pSrc ); } },
+		{ L"Blt",8.0f,0.0f,false,[=,&srcRect](){ pDst->Blt( origin,srcRect,*pSrc ); } },
+		{ L"BltBlend",12.0f,16.0f,false,[=,&srcRect](){ pDst->BltBlend( origin,srcRect,*pSrc,100 ); } },
+		{ L"BltAlpha",12.0f,17.0f,false,[=,&srcRect](){ pDst->BltAlpha( origin,srcRect,*pSrc ); } },
+		{ L"BltKey",12.0f,1.0f,false,[=,&srcRect](){ pDst->BltKey( origin,srcRect,*pSrc,BLACK ); } },
+		{ L"BlendSSE",12.0f,16.0f,false,[=](){ pDst->BlendSSE( *pSrc,100 ); } },
+		{ L"BlendHalfSSE",12.0f,3.0f,false,[=](){ pDst->BlendHalfSSE( *pSrc ); } },
+		{ L"BlendAlphaSSE",12.0f,17.0f,false,[=](){ pDst->BlendAlphaSSE( *pSrc ); } },
+		{ L"BlendAlphaLinear",12.0f,17.0f,false,[=](){ pDst->BlendAlphaLinear( *pSrc ); } },
+		{ L"Compose<LinearAlpha,Scalar>",12.0f,17.0f,false,
+			[=](){ pDst->Compose< Pixel::LinearAlpha,Pixel::Scalar >( *pSrc ); } },
+		{ L"BlendAlphaPremultipliedSSE",12.0f,13.0f,false,[=](){ pDst->BlendAlphaPremultipliedSSE( *pSrc ); } },
+		{ L"BltSSE",8.0f,0.0f,false,[=,&srcRect](){ pDst->BltSSE( origin,srcRect,*pSrc ); } },
+		{ L"BltBlendSSE",12.0f,16.0f,false,[=,&srcRect](){ pDst->BltBlendSSE( origin,srcRect,*pSrc,100 ); } },
+		{ L"BltAlphaSSE",12.0f,17.0f,false,[=,&srcRect](){ pDst->BltAlphaSSE( origin,srcRect,*pSrc ); } },
+		{ L"BltAlphaLinear",12.0f,17.0f,false,[=,&srcRect](){ pDst->BltAlphaLinear( origin,srcRect,*pSrc ); } },
+		{ L"BltKeySSE",12.0f,1.0f,false,[=,&srcRect](){ pDst->BltKeySSE( origin,srcRect,*pSrc,BLACK ); } },
+		// nominal traffic of the untiled kernel, so the tiled one can read above 100%
+		{ L"BltAlphaSSE sprite",12.0f,17.0f,false,[=,&srcRect](){ pDst->BltAlphaSSE( origin,srcRect,*pSprite ); } },
+		{ L"BltAlphaSSE sprite tiled",12.0f,17.0f,false,
+			[=,&srcRect](){ pDst->BltAlphaSSE( origin,srcRect,*pSpriteTiled ); } },
+		{ L"Compose<Additive>",12.0f,4.0f,false,[=](){ pDst->Compose< Pixel::Additive >( *pSrc ); } },
+		{ L"Compose<Multiply>",12.0f,16.0f,false,[=](){ pDst->Compose< Pixel::Multiply >( *pSrc ); } },
+		{ L"Compose<Screen>",12.0f,16.0f,false,[=](){ pDst->Compose< Pixel::Screen >( *pSrc ); } },
+		{ L"Compose<Overlay>",12.0f,28.0f,false,[=](){ pDst->Compose< Pixel::Overlay >( *pSrc ); } },
+		{ L"Compose<Alpha<Additive>>",12.0f,17.0f,false,
+			[=](){ pDst->Compose< Pixel::Alpha< Pixel::Additive > >( *pSrc ); } },
+		{ L"Compose<PremultipliedAlpha<Screen>>",12.0f,40.0f,false,
+			[=](){ pDst->Compose< Pixel::PremultipliedAlpha< Pixel::Screen > >( *pSrc ); } },
+	};
+
+	// the roof that matters is the one for the kernels' own footprint (two surfaces)
+	const Roof roof = Calibrate( 2 * height * dst.GetPitch() );
+	const Roof dram = Calibrate( 256 * 1024 * 1024 );
+
+	std::wstringstream ss;
+	ss.precision( 2 );
+	ss << std::fixed;
+	ss << L"Roof (" << width << L"x" << height << L" working set): read [" << roof.readBandwidth
+		<< L"] write [" << roof.writeBandwidth << L"] copy [" << roof.copyBandwidth
+		<< L"] GB/s, SIMD [" << roof.laneOpsPerSec << L"] G lane ops/s" << std::endl;
+	ss << L"Roof (DRAM working set): read [" << dram.readBandwidth
+		<< L"] write [" << dram.writeBandwidth << L"] copy [" << dram.copyBandwidth
+		<< L"] GB/s" << std::endl;
+	const std::wstring failure = CheckPremultipliedSubtractive( src );
+	ss << L"Check: " << ( failure.empty() ? L"ok" : L"FAILED " + failure ) << std::endl << std::endl;
+	ss << std::left << std::setw( 30 ) << L"Kernel" << std::right
+		<< std::setw( 8 ) << L"ms" << std::setw( 9 ) << L"GB/s" << std::setw( 10 ) << L"Gops/s"
+		<< std::setw( 8 ) << L"ops/B" << std::setw( 9 ) << L"bound" << std::setw( 7 ) << L"roof"
+		<< std::setw( 8 ) << L"cyc/px" << std::setw( 6 ) << L"IPC" << std::setw( 9 ) << L"L1m/px"
+		<< std::setw( 9 ) << L"LLCm/px" << L"  " << std::endl;
+
+	// one extra (warm) run of each kernel under the hardware counters; events that could
+	// not be opened print as 0 and cycles are TSC ticks without perf access
+	PerfCounters counters;
+	const float nPixels = (float)width * (float)height;
+	for( const Kernel& k : kernels )
+	{
+		const float t = BestOf( nReps,k.run );
+		counters.Start();
+		k.run();
+		const PerfCounters::Sample sample = counters.Stop();
+		const float ipc = sample.cycles > 0 ? (float)sample.instructions / (float)sample.cycles : 0.0f;
+		const float bytes = k.bytesPerPixel * nPixels;
+		const float ops = k.opsPerPixel * nPixels;
+		const float roofBandwidth = k.writeOnly ? roof.writeBandwidth : roof.copyBandwidth;
+		const float memoryTime = bytes / ( roofBandwidth * 1e9f );
+		const float computeTime = ops / ( roof.laneOpsPerSec * 1e9f );
+		const bool memoryBound = memoryTime >= computeTime;
+		const float fraction = max( memoryTime,computeTime ) / t;
+		ss << std::left << std::setw( 30 ) << k.name << std::right
+			<< std::setw( 8 ) << t * 1000.0f
+			<< std::setw( 9 ) << bytes / t / 1e9f
+			<< std::setw( 10 ) << ops / t / 1e9f
+			<< std::setw( 8 ) << k.opsPerPixel / k.bytesPerPixel
+			<< std::setw( 9 ) << ( memoryBound ? L"memory" : L"compute" )
+			<< std::setw( 6 ) << (int)( fraction * 100.0f + 0.5f ) << L"%"
+			<< std::setw( 8 ) << (float)sample.cycles / nPixels
+			<< std::setw( 6 ) << ipc
+			<< std::setw( 9 ) << std::setprecision( 4 ) << (float)sample.l1Misses / nPixels
+			<< std::setw( 9 ) << (float)sample.llcMisses / nPixels << std::setprecision( 2 )
+			<< L"  " << Bar( fraction ) << std::endl;
+	}
+	report << ss.str();
+}
\ No newline at end of file
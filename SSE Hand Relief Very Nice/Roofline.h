@@ -0,0 +1,52 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	Roofline.h																			  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include <ostream>
+#include <stddef.h>
+
+// calibrates this machine's achievable streaming bandwidth and per-core SIMD throughput
+// with synthetic kernels, then times every Surface kernel and reports how close it gets
+// to whichever roof (memory or compute) bounds it
+class Roofline
+{
+public:
+	struct Roof
+	{
+		// GB/s, bytes moved (reads + writes) per second
+		float readBandwidth;
+		float writeBandwidth;
+		float copyBandwidth;
+		// billions of 16-bit SIMD lane operations per second on one core
+		float laneOpsPerSec;
+	};
+public:
+	// kernels run on surfaces of the given size (defaults to the frame size)
+	Roofline( unsigned int width = 1280,unsigned int height = 720 );
+	// bandwidth measured over a working set of the given size
+	Roof Calibrate( size_t workingSetBytes ) const;
+	// calibrate, time all kernels and write the table / bar plot to report
+	void Run( std::wostream& report ) const;
+private:
+	static const int nReps = 10;
+	unsigned int width;
+	unsigned int height;
+};
\ No newline at end of file
@@ -0,0 +1,214 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	SpatialGrid.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "SpatialGrid.h"
+#include <Windows.h>
+#include <math.h>
+#include <assert.h>
+
+SpatialGrid::SpatialGrid( const RectF& bounds,float cellSize )
+	:
+	bounds( bounds ),
+	invCellSize( 1.0f / cellSize ),
+	nCellsX( max( (int)ceil( bounds.GetWidth() / cellSize ),1 ) ),
+	nCellsY( max( (int)ceil( bounds.GetHeight() / cellSize ),1 ) ),
+	queryStamp( 0 )
+{
+	cells.resize( nCellsX * nCellsY );
+}
+
+int SpatialGrid::Insert( const RectF& rect )
+{
+	int id;
+	if( freeIds.empty() )
+	{
+		id = (int)objects.size();
+		objects.push_back( Object() );
+		stamps.push_back( 0 );
+	}
+	else
+	{
+		id = freeIds.back();
+		freeIds.pop_back();
+	}
+	Object& obj = objects[id];
+	obj.rect = rect;
+	obj.range = RangeOf( rect );
+	obj.alive = true;
+	AddToCells( id,obj.range );
+	return id;
+}
+
+void SpatialGrid::Remove( int id )
+{
+	assert( objects[id].alive );
+	RemoveFromCells( id,objects[id].range );
+	objects[id].alive = false;
+	freeIds.push_back( id );
+}
+
+void SpatialGrid::Move( int id,const RectF& rect )
+{
+	Object& obj = objects[id];
+	assert( obj.alive );
+	obj.rect = rect;
+	const CellRange range = RangeOf( rect );
+	if( range.left != obj.range.left || range.right != obj.range.right ||
+		range.top != obj.range.top || range.bottom != obj.range.bottom )
+	{
+		RemoveFromCells( id,obj.range );
+		AddToCells( id,range );
+		obj.range = range;
+	}
+}
+
+const RectF& SpatialGrid::GetRect( int id ) const
+{
+	assert( objects[id].alive );
+	return objects[id].rect;
+}
+
+void SpatialGrid::Query( const RectF& rect,std::vector<int>& out ) const
+{
+	NextStamp();
+	const CellRange range = RangeOf( rect );
+	for( int y = range.top; y <= range.bottom; y++ )
+	{
+		for( int x = range.left; x <= range.right; x++ )
+		{
+			for( int id : cells[y * nCellsX + x] )
+			{
+				if( stamps[id] != queryStamp )
+				{
+					stamps[id] = queryStamp;
+					if( objects[id].rect.Overlaps( rect ) )
+					{
+						out.push_back( id );
+					}
+				}
+			}
+		}
+	}
+}
+
+void SpatialGrid::QueryPoint( Vec2 p,std::vector<int>& out ) const
+{
+	// an object is listed at most once per cell, so no stamping needed
+	for( int id : cells[CellY( p.y ) * nCellsX + CellX( p.x )] )
+	{
+		if( objects[id].rect.Contains( p ) )
+		{
+			out.push_back( id );
+		}
+	}
+}
+
+void SpatialGrid::QueryPairs( std::vector< std::pair<int,int> >& out ) const
+{
+	for( int y = 0; y < nCellsY; y++ )
+	{
+		for( int x = 0; x < nCellsX; x++ )
+		{
+			const std::vector<int>& cell = cells[y * nCellsX + x];
+			for( size_t i = 0; i < cell.size(); i++ )
+			{
+				const Object& a = objects[cell[i]];
+				for( size_t j = i + 1; j < cell.size(); j++ )
+				{
+					const Object& b = objects[cell[j]];
+					// a pair shares every cell of the overlap of their ranges; only the
+					// top left one of those reports it
+					if( x != max( a.range.left,b.range.left ) || y != max( a.range.top,b.range.top ) )
+					{
+						continue;
+					}
+					if( a.rect.Overlaps( b.rect ) )
+					{
+						out.push_back( std::make_pair( min( cell[i],cell[j] ),max( cell[i],cell[j] ) ) );
+					}
+				}
+			}
+		}
+	}
+}
+
+SpatialGrid::CellRange SpatialGrid::RangeOf( const RectF& rect ) const
+{
+	CellRange range;
+	range.left = CellX( rect.left );
+	range.right = CellX( rect.right );
+	range.top = CellY( rect.top );
+	range.bottom = CellY( rect.bottom );
+	return range;
+}
+
+int SpatialGrid::CellX( float x ) const
+{
+	const int cell = (int)floor( ( x - bounds.left ) * invCellSize );
+	return min( max( cell,0 ),nCellsX - 1 );
+}
+
+int SpatialGrid::CellY( float y ) const
+{
+	const int cell = (int)floor( ( y - bounds.top ) * invCellSize );
+	return min( max( cell,0 ),nCellsY - 1 );
+}
+
+void SpatialGrid::AddToCells( int id,const CellRange& range )
+{
+	for( int y = range.top; y <= range.bottom; y++ )
+	{
+		for( int x = range.left; x <= range.right; x++ )
+		{
+			cells[y * nCellsX + x].push_back( id );
+		}
+	}
+}
+
+void SpatialGrid::RemoveFromCells( int id,const CellRange& range )
+{
+	for( int y = range.top; y <= range.bottom; y++ )
+	{
+		for( int x = range.left; x <= range.right; x++ )
+		{
+			std::vector<int>& cell = cells[y * nCellsX + x];
+			for( size_t i = 0; i < cell.size(); i++ )
+			{
+				if( cell[i] == id )
+				{
+					cell[i] = cell.back();
+					cell.pop_back();
+					break;
+				}
+			}
+		}
+	}
+}
+
+void SpatialGrid::NextStamp() const
+{
+	queryStamp++;
+	// on wraparound old stamps could collide with new ones
+	if( queryStamp == 0 )
+	{
+		std::fill( stamps.begin(),stamps.end(),0 );
+		queryStamp = 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	SpatialGrid.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include "Rect.h"
+#include <vector>
+#include <utility>
+
+// uniform grid over a fixed world rect; every object is listed in each cell it covers
+// best when objects are of similar size and spread over a known area (sprites on screen)
+// objects outside the bounds are kept in the border cells, so queries stay correct
+class SpatialGrid
+{
+public:
+	SpatialGrid( const RectF& bounds,float cellSize );
+	// returns the id used by Remove / Move / GetRect and reported by the queries
+	int Insert( const RectF& rect );
+	void Remove( int id );
+	// only touches the cell lists when the set of covered cells changes
+	void Move( int id,const RectF& rect );
+	const RectF& GetRect( int id ) const;
+	// ids of all objects overlapping rect (same test as _Rect::Overlaps), appended to out
+	void Query( const RectF& rect,std::vector<int>& out ) const;
+	// ids of all objects containing p (same test as _Rect::Contains), appended to out
+	void QueryPoint( Vec2 p,std::vector<int>& out ) const;
+	// every overlapping pair once, lower id first, appended to out
+	void QueryPairs( std::vector< std::pair<int,int> >& out ) const;
+private:
+	// inclusive cell index range
+	struct CellRange
+	{
+		int left;
+		int right;
+		int top;
+		int bottom;
+	};
+	struct Object
+	{
+		RectF rect;
+		CellRange range;
+		bool alive;
+	};
+private:
+	CellRange RangeOf( const RectF& rect ) const;
+	int CellX( float x ) const;
+	int CellY( float y ) const;
+	void AddToCells( int id,const CellRange& range );
+	void RemoveFromCells( int id,const CellRange& range );
+	void NextStamp() const;
+private:
+	RectF bounds;
+	float invCellSize;
+	int nCellsX;
+	int nCellsY;
+	std::vector< std::vector<int> > cells;
+	std::vector<Object> objects;
+	std::vector<int> freeIds;
+	// objects spanning several cells are reported once per query using a query stamp
+	mutable std::vector<unsigned int> stamps;
+	mutable unsigned int queryStamp;
+};
\ No newline at end of file
@@ -0,0 +1,163 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	SpriteBatch.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "SpriteBatch.h"
+#include "Surface.h"
+#include "Profiler.h"
+#include <algorithm>
+
+SpriteBatch::SpriteBatch( unsigned int nThreads )
+{
+	if( nThreads > 1 )
+	{
+		pPool.reset( new WorkerPool( nThreads - 1 ) );
+	}
+}
+
+void SpriteBatch::Begin()
+{
+	sprites.clear();
+}
+
+void SpriteBatch::Draw( const Surface& src,const RectI& srcRect,Vei2 dstPt,
+	BlendMode mode,int layer,unsigned char alpha )
+{
+	Sprite s;
+	s.pSrc = &src;
+	s.srcRect = srcRect;
+	s.dstPt = dstPt;
+	s.layer = layer;
+	s.order = (unsigned int)sprites.size();
+	s.mode = mode;
+	s.alpha = alpha;
+	sprites.push_back( s );
+}
+
+void SpriteBatch::End( Surface& target )
+{
+	PROFILE_FUNCTION();
+	const RectI screen( 0,(int)target.GetWidth(),0,(int)target.GetHeight() );
+
+	// cull everything that misses the target
+	{
+		PROFILE_ZONE( "SpriteBatch::Cull" );
+		sprites.erase( std::remove_if( sprites.begin(),sprites.end(),[&screen]( const Sprite& s )
+		{
+			const RectI dst( s.dstPt.x,s.dstPt.x + s.srcRect.GetWidth(),
+				s.dstPt.y,s.dstPt.y + s.srcRect.GetHeight() );
+			return !dst.Overlaps( screen );
+		} ),sprites.end() );
+	}
+
+	{
+		PROFILE_ZONE( "SpriteBatch::Sort" );
+		std::sort( sprites.begin(),sprites.end(),[]( const Sprite& a,const Sprite& b )
+		{
+			if( a.layer != b.layer )
+			{
+				return a.layer < b.layer;
+			}
+			if( a.pSrc != b.pSrc )
+			{
+				return a.pSrc < b.pSrc;
+			}
+			if( a.mode != b.mode )
+			{
+				return a.mode < b.mode;
+			}
+			return a.order < b.order;
+		} );
+	}
+
+	if( !pPool )
+	{
+		Composite( target,screen );
+		return;
+	}
+	// a few bands per thread so uneven sprite density still balances
+	// bands are whole rows of opacity tiles, so no two bands dirty the same tile of target
+	const int nBands = (int)pPool->GetThreadCount() * 4;
+	const int tileMask = ( 1 << Surface::opacityTileShift ) - 1;
+	const int bandHeight = ( ( screen.bottom + nBands - 1 ) / nBands + tileMask ) & ~tileMask;
+	pPool->Run( nBands,[&]( unsigned int band )
+	{
+		const int top = (int)band * bandHeight;
+		const RectI clip( 0,screen.right,top,min( top + bandHeight,screen.bottom ) );
+		if( clip.GetHeight() > 0 )
+		{
+			Composite( target,clip );
+		}
+	} );
+}
+
+unsigned int SpriteBatch::GetSpriteCount() const
+{
+	return (unsigned int)sprites.size();
+}
+
+void SpriteBatch::Composite( Surface& target,const RectI& clip ) const
+{
+	PROFILE_FUNCTION();
+	for( const Sprite& s : sprites )
+	{
+		BltSprite( target,s,clip );
+	}
+}
+
+void SpriteBatch::BltSprite( Surface& target,const Sprite& s,const RectI& clip )
+{
+	// clip the destination rect and shift the source rect to match
+	const int left = max( s.dstPt.x,clip.left );
+	const int top = max( s.dstPt.y,clip.top );
+	const int right = min( s.dstPt.x + s.srcRect.GetWidth(),clip.right );
+	const int bottom = min( s.dstPt.y + s.srcRect.GetHeight(),clip.bottom );
+	if( left >= right || top >= bottom )
+	{
+		return;
+	}
+	const RectI srcRect(
+		s.srcRect.left + left - s.dstPt.x,
+		s.srcRect.left + right - s.dstPt.x,
+		s.srcRect.top + top - s.dstPt.y,
+		s.srcRect.top + bottom - s.dstPt.y );
+	const Vei2 dstPt = { left,top };
+
+	switch( s.mode )
+	{
+	case Copy:
+		target.Compose< Pixel::Copy >( dstPt,srcRect,*s.pSrc );
+		break;
+	case Blend:
+		target.Compose< Pixel::ConstantAlpha >( dstPt,srcRect,*s.pSrc,Pixel::ConstantAlpha( s.alpha ) );
+		break;
+	case Alpha:
+		target.Compose< Pixel::PerPixelAlpha >( dstPt,srcRect,*s.pSrc );
+		break;
+	case Premultiplied:
+		target.Compose< Pixel::Premultiplied >( dstPt,srcRect,*s.pSrc );
+		break;
+	case Additive:
+		target.Compose< Pixel::Additive >( dstPt,srcRect,*s.pSrc );
+		break;
+	case LinearAlpha:
+		target.Compose< Pixel::LinearAlpha >( dstPt,srcRect,*s.pSrc );
+		break;
+	}
+}
\ No newline at end of file
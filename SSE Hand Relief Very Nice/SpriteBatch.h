@@ -0,0 +1,76 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	SpriteBatch.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include "Rect.h"
+#include "WorkerPool.h"
+#include <vector>
+#include <memory>
+
+class Surface;
+
+// collects sprite blits for a frame, then culls, sorts and composites them in one pass
+// sprites are ordered by layer first (painter's order between layers), then grouped by
+// source surface and blend mode; sprites within one layer must not depend on each
+// other's draw order (submission order is kept within a group)
+// with nThreads > 1 the target is split into horizontal bands, one per job, and every
+// band composites the whole sorted list clipped to itself, so no two threads touch a row
+class SpriteBatch
+{
+public:
+	enum BlendMode
+	{
+		Copy,
+		Blend,
+		Alpha,
+		Premultiplied,
+		Additive,
+		// per-pixel alpha blended in linear light
+		LinearAlpha
+	};
+public:
+	SpriteBatch( unsigned int nThreads = 1 );
+	// clears the previous frame's submissions (storage is kept)
+	void Begin();
+	// alpha is only used by Blend; src must stay alive until End
+	void Draw( const Surface& src,const RectI& srcRect,Vei2 dstPt,
+		BlendMode mode = Alpha,int layer = 0,unsigned char alpha = 255 );
+	void End( Surface& target );
+	unsigned int GetSpriteCount() const;
+private:
+	struct Sprite
+	{
+		const Surface* pSrc;
+		RectI srcRect;
+		Vei2 dstPt;
+		int layer;
+		unsigned int order;
+		BlendMode mode;
+		unsigned char alpha;
+	};
+private:
+	void Composite( Surface& target,const RectI& band ) const;
+	static void BltSprite( Surface& target,const Sprite& s,const RectI& clip );
+private:
+	std::vector<Sprite> sprites;
+	std::unique_ptr<WorkerPool> pPool;
+};
\ No newline at end of file
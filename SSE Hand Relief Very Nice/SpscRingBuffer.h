@@ -0,0 +1,120 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	SpscRingBuffer.h																	  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+
+// fixed capacity lock-free queue for exactly one producer thread and one consumer thread
+// when full, the oldest element is discarded (same policy as the old push + pop on
+// std::queue) without the producer touching head: Push always writes and advances tail,
+// and the consumer skips forward to the newest capacity elements when it has fallen behind
+// there are 2 * capacity slots, so the producer can only overwrite the slot being read
+// once it is a whole capacity further ahead; Pop / Peek copy the slot, then recheck tail
+// and retry if that happened (seqlock style, hence trivially copyable elements only)
+template< class T,unsigned int capacity >
+class SpscRingBuffer
+{
+	static_assert( capacity > 0 && ( capacity & ( capacity - 1 ) ) == 0,
+		"SpscRingBuffer capacity must be a power of two" );
+	static_assert( std::is_trivially_copyable< T >::value,
+		"SpscRingBuffer elements may be copied while being overwritten" );
+public:
+	SpscRingBuffer()
+		:
+		head( 0 ),
+		tail( 0 )
+	{}
+	SpscRingBuffer( const SpscRingBuffer& ) = delete;
+	SpscRingBuffer& operator=( const SpscRingBuffer& ) = delete;
+	// producer only
+	void Push( const T& item )
+	{
+		const unsigned int t = tail.load( std::memory_order_relaxed );
+		// keeps the slot write from becoming visible before the previous Push's tail store,
+		// which is what the consumer's recheck relies on
+		std::atomic_thread_fence( std::memory_order_release );
+		slots[t & mask] = item;
+		tail.store( t + 1,std::memory_order_release );
+	}
+	// consumer only
+	bool Pop( T& item )
+	{
+		unsigned int h;
+		if( !Read( item,h ) )
+		{
+			return false;
+		}
+		head.store( h + 1,std::memory_order_release );
+		return true;
+	}
+	// consumer only
+	bool Peek( T& item ) const
+	{
+		unsigned int h;
+		return Read( item,h );
+	}
+	// consumer only
+	void Clear()
+	{
+		head.store( tail.load( std::memory_order_acquire ),std::memory_order_release );
+	}
+	bool Empty() const
+	{
+		return head.load( std::memory_order_acquire ) == tail.load( std::memory_order_acquire );
+	}
+private:
+	// copies the oldest element still held into item and returns its index in h
+	bool Read( T& item,unsigned int& h ) const
+	{
+		h = head.load( std::memory_order_relaxed );
+		unsigned int t = tail.load( std::memory_order_acquire );
+		while( h != t )
+		{
+			if( t - h > capacity )
+			{
+				h = t - capacity;
+			}
+			item = slots[h & mask];
+			std::atomic_thread_fence( std::memory_order_acquire );
+			t = tail.load( std::memory_order_relaxed );
+			// the producer writes index h + 2 * capacity into this slot only while tail is there
+			if( t - h < 2 * capacity )
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+private:
+	static const unsigned int nSlots = 2 * capacity;
+	static const unsigned int mask = nSlots - 1;
+	static const unsigned int cacheLine = 64;
+	// VS2013 has no alignas, so instead of aligning head and tail each one is surrounded by
+	// a full cache line of padding; whatever the object's alignment, no line can then hold
+	// both indices or an index and a neighbouring object/the slots
+	char padHead[cacheLine];
+	std::atomic<unsigned int> head;
+	char padMid[cacheLine - sizeof( std::atomic<unsigned int> )];
+	std::atomic<unsigned int> tail;
+	char padTail[cacheLine - sizeof( std::atomic<unsigned int> )];
+	T slots[nSlots];
+};
\ No newline at end of file
@@ -2,8 +2,11 @@
 
 #include "Colors.h"
 #include "Font.h"
+#include "Profiler.h"
+#include "PixelPipeline.h"
 #include <gdiplus.h>
 #include <string>
+#include <vector>
 #include <assert.h>
 #include <immintrin.h>
 #pragma comment( lib,"gdiplus.lib" )
@@ -19,7 +22,9 @@ public:
 		buffer( nullptr ),
 		width( width ),
 		height( height ),
-		pixelPitch( CalculatePixelPitch( width,byteAlignment ) )
+		pixelPitch( CalculatePixelPitch( width,byteAlignment ) ),
+		nTilesX( 0 ),
+		nTilesY( 0 )
 	{
 		buffer = new Color[height * pixelPitch];
 	}
@@ -28,7 +33,10 @@ public:
 		buffer( source.buffer ),
 		width( source.width ),
 		height( source.height ),
-		pixelPitch( source.pixelPitch )
+		pixelPitch( source.pixelPitch ),
+		opacityTiles( std::move( source.opacityTiles ) ),
+		nTilesX( source.nTilesX ),
+		nTilesY( source.nTilesY )
 	{
 		source.buffer = nullptr;
 	}
@@ -37,10 +45,15 @@ public:
 		buffer( nullptr ),
 		width( src.width ),
 		height( src.height ),
-		pixelPitch( src.pixelPitch )
+		pixelPitch( src.pixelPitch ),
+		nTilesX( 0 ),
+		nTilesY( 0 )
 	{
 		buffer = new Color[height * pixelPitch];
 		Copy( src );
+		opacityTiles = src.opacityTiles;
+		nTilesX = src.nTilesX;
+		nTilesY = src.nTilesY;
 	}
 	Surface& operator=( Surface&& donor )
 	{
@@ -48,6 +61,9 @@ public:
 		height = donor.height;
 		pixelPitch = donor.pixelPitch;
 		buffer = donor.buffer;
+		opacityTiles = std::move( donor.opacityTiles );
+		nTilesX = donor.nTilesX;
+		nTilesY = donor.nTilesY;
 		donor.buffer = nullptr;
 		return *this;
 	}
@@ -62,6 +78,7 @@ public:
 	}
 	inline void Present( const unsigned int pitch,BYTE* const buffer ) const
 	{
+		PROFILE_FUNCTION();
 		const unsigned int bytePitch = GetPitch();
 		if( pitch == bytePitch )
 		{
@@ -75,6 +92,20 @@ public:
 			}
 		}
 	}
+	// same, also copying each row into a second destination (a FrameExport slot); the
+	// export is a second full frame copy (width * height * 4 more bytes written per frame),
+	// only the reads of the surface are shared since each row is still in cache
+	inline void Present( const unsigned int pitch,BYTE* const buffer,
+		const unsigned int exportPitch,BYTE* const exportBuffer ) const
+	{
+		PROFILE_FUNCTION();
+		for( unsigned int y = 0; y < height; y++ )
+		{
+			const Color* const pRow = &( this->buffer )[pixelPitch * y];
+			memcpy( &buffer[pitch * y],pRow,sizeof( Color ) * width );
+			memcpy( &exportBuffer[exportPitch * y],pRow,sizeof( Color ) * width );
+		}
+	}
 	inline void PutPixel( unsigned int x,unsigned int y,Color c )
 	{
 		assert( x >= 0 );
@@ -82,6 +113,10 @@ public:
 		assert( x < width );
 		assert( y < height );
 		buffer[y * pixelPitch + x] = c;
+		if( !opacityTiles.empty() )
+		{
+			opacityTiles[( y >> opacityTileShift ) * nTilesX + ( x >> opacityTileShift )] = TileDirty;
+		}
 	}
 	inline void PutPixelAlpha( unsigned int x,unsigned int y,Color c )
 	{
@@ -124,8 +159,10 @@ public:
 	{
 		return pixelPitch;
 	}
+	// writes through the returned pointer can't be tracked, so this dirties every opacity tile
 	inline Color* const GetBuffer()
 	{
+		InvalidateOpacity();
 		return buffer;
 	}
 	inline const Color* const GetBufferConst() const
@@ -134,6 +171,8 @@ public:
 	}
 	void PremultiplyAlpha()
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		for( unsigned int y = 0; y < height; y++ )
 		{
 			for( unsigned int x = 0; x < width; x++ )
@@ -154,6 +193,7 @@ public:
 	static Surface FromFile( const std::wstring& name,
 		unsigned int byteAlignment = DEFAULT_SURFACE_ALIGNMENT )
 	{
+		PROFILE_FUNCTION();
 		Gdiplus::Bitmap bitmap( name.c_str() );
 		const unsigned int width = bitmap.GetWidth();
 		const unsigned int height = bitmap.GetHeight();
@@ -171,48 +211,17 @@ public:
 
 		return surf;
 	}
+	// writes a BMP on the calling thread; FrameCapture does screenshots without the hitch
 	void Save( const std::wstring& filename ) const
 	{
-		auto GetEncoderClsid = []( const WCHAR* format,CLSID* pClsid ) -> int
-		{
-			UINT  num = 0;          // number of image encoders
-			UINT  size = 0;         // size of the image encoder array in bytes
-
-			Gdiplus::ImageCodecInfo* pImageCodecInfo = NULL;
-
-			Gdiplus::GetImageEncodersSize( &num,&size );
-			if( size == 0 )
-				return -1;  // Failure
-
-			pImageCodecInfo = ( Gdiplus::ImageCodecInfo* )( malloc( size ) );
-			if( pImageCodecInfo == NULL )
-				return -1;  // Failure
-
-			GetImageEncoders( num,size,pImageCodecInfo );
-
-			for( UINT j = 0; j < num; ++j )
-			{
-				if( wcscmp( pImageCodecInfo[j].MimeType,format ) == 0 )
-				{
-					*pClsid = pImageCodecInfo[j].Clsid;
-					free( pImageCodecInfo );
-					return j;  // Success
-				}
-			}
-
-			free( pImageCodecInfo );
-			return -1;  // Failure
-		};
-
-		{
-			Gdiplus::Bitmap bitmap( width,height,GetPitch(),PixelFormat32bppARGB,(BYTE*)buffer );
-			CLSID bmpID;
-			GetEncoderClsid( L"image/bmp",&bmpID );
-			bitmap.Save( filename.c_str(),&bmpID,NULL );
-		}
+		PROFILE_FUNCTION();
+		Gdiplus::Bitmap bitmap( width,height,GetPitch(),PixelFormat32bppARGB,(BYTE*)buffer );
+		bitmap.Save( filename.c_str(),&GetBmpEncoderClsid(),NULL );
 	}
 	void Copy( const Surface& src )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		assert( width == src.width );
 		assert( height == src.height );
 		if( pixelPitch == src.pixelPitch )
@@ -229,12 +238,28 @@ public:
 	}
 	void Clear()
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		memset( buffer,0,height * GetPitch() );
 	}
+	// 64-bit FNV-1a over the visible pixels (row padding is ignored)
+	unsigned long long Checksum() const
+	{
+		unsigned long long hash = 14695981039346656037ull;
+		for( unsigned int y = 0; y < height; y++ )
+		{
+			for( const Color* i = &buffer[pixelPitch * y],*end = i + width; i < end; i++ )
+			{
+				hash = ( hash ^ i->c ) * 1099511628211ull;
+			}
+		}
+		return hash;
+	}
 	//////////////////////////////////
 	// Bench Functions (straight 'C')
 	void FillSlow( Color c )
 	{
+		PROFILE_FUNCTION();
 		const unsigned int height = GetHeight();
 		const unsigned int width = GetWidth();
 		for( unsigned int y = 0; y < height; y++ )
@@ -247,6 +272,8 @@ public:
 	}
 	void Fill( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		for( Color* i = buffer,*end = &buffer[pixelPitch * height]; i < end; i++ )
 		{
 			*i = c;
@@ -254,6 +281,8 @@ public:
 	}
 	void Fade( unsigned char alpha )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		for( Color* i = buffer,*end = &buffer[pixelPitch * height]; i < end; i++ )
 		{
 			const Color src = *i;
@@ -265,6 +294,8 @@ public:
 	}
 	void FadeShift( unsigned char a )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const unsigned int alpha = a;
 		const unsigned int mask = 0xFF;
 		for( Color* i = buffer,*end = &buffer[pixelPitch * height]; i < end; i++ )
@@ -278,6 +309,8 @@ public:
 	}
 	void FadeHalf()
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		for( Color* i = buffer,*end = &buffer[pixelPitch * height]; i < end; i++ )
 		{
 			const Color src = *i;
@@ -289,6 +322,8 @@ public:
 	}
 	void FadeHalfPacked()
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const unsigned int shiftMask = 0x007F7F7F;
 		for( Color* i = buffer,*end = &buffer[pixelPitch * height]; i < end; i++ )
 		{
@@ -310,6 +345,8 @@ public:
 	//}
 	void Tint( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		for( Color* i = buffer,*end = &buffer[pixelPitch * height]; i < end; i++ )
 		{
 			// load destination pixel
@@ -326,6 +363,8 @@ public:
 	}
 	void TintShift( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const unsigned int mask = 0xFF;
 		for( Color* i = buffer,*end = &buffer[pixelPitch * height]; i < end; i++ )
 		{
@@ -349,6 +388,8 @@ public:
 	}
 	void TintPrecomputed( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		// unpack and premultiply tint channels
 		const unsigned int rPrecomp = c.r * c.x;
 		const unsigned int gPrecomp = c.g * c.x;
@@ -371,6 +412,8 @@ public:
 	}
 	void TintPrecomputedPacked( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		// unpack and premultiply tint channels
 		const unsigned int rPrecomp = ( c.r * c.x ) >> 8;
 		const unsigned int gPrecomp = ( c.g * c.x ) >> 8;
@@ -395,6 +438,8 @@ public:
 	}
 	void TintHalfPacked( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const unsigned int shiftMask = 0x007F7F7F;
 		const Color preComp = ( c >> 1 ) & shiftMask;
 		for( Color* i = buffer,*end = &buffer[pixelPitch * height]; i < end; i++ )
@@ -405,88 +450,28 @@ public:
 	}
 	void Blend( Surface& s,unsigned char alpha )
 	{
-		const unsigned int mask = 0xFF;
-		const unsigned int a = alpha;
-		for( Color* i = buffer,*end = &buffer[pixelPitch * height], *j = s.GetBuffer(); 
-			i < end; i++,j++ )
-		{
-			// load source and destination pixels
-			const Color d = *i;
-			const Color s = *j;
-			
-			// unpack source components
-			const unsigned int r = ( s >> 16 ) & mask;
-			const unsigned int g = ( s >> 8  ) & mask;
-			const unsigned int b =   s         & mask;
-
-			// unpack source components and blend channels
-			const unsigned int rsltRed =   ( ( ( d >> 16 ) & mask ) *  ( 255 - a ) + r * a ) >> 8;
-			const unsigned int rsltGreen = ( ( ( d >> 8  ) & mask ) *  ( 255 - a ) + g * a ) >> 8;
-			const unsigned int rsltBlue =  (   ( d         & mask ) *  ( 255 - a ) + b * a ) >> 8;
-
-			// pack channels back into pixel and fire pixel onto surface
-			*i = ( rsltRed << 16 ) | ( rsltGreen << 8 ) | rsltBlue;
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::ConstantAlpha,Pixel::Scalar >( s,Pixel::ConstantAlpha( alpha ) );
 	}
 	void BlendHalfPacked( Surface& s )
 	{
-		const unsigned int shiftMask = 0x007F7F7F;
-		for( Color* i = buffer,*end = &buffer[pixelPitch * height],*j = s.GetBuffer();
-			i < end; i++,j++ )
-		{
-			// divide source and destination channels by 2 and sum (no carry will happen)
-			*i = ( ( *i >> 1 ) & shiftMask ) + ( ( *j >> 1 ) & shiftMask );
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::HalfAverage,Pixel::Scalar >( s );
 	}
 	void BlendAlpha( Surface& s )
 	{
-		const unsigned int mask = 0xFF;
-		for( Color* i = buffer,*end = &buffer[pixelPitch * height],*j = s.GetBuffer();
-			i < end; i++,j++ )
-		{
-			// load (premultiplied) source and destination pixels
-			const Color d = *i;
-			const Color s = *j;
-
-			// unpack source components
-			const unsigned int a =   s >> 24;
-			const unsigned int r = ( s >> 16 ) & mask;
-			const unsigned int g = ( s >> 8  ) & mask;
-			const unsigned int b =   s         & mask;
-
-			// unpack source components and blend channels
-			const unsigned int rsltRed =   ( ( ( d >> 16 ) & mask ) *  ( 255 - a ) + r * a ) >> 8;
-			const unsigned int rsltGreen = ( ( ( d >> 8  ) & mask ) *  ( 255 - a ) + g * a ) >> 8;
-			const unsigned int rsltBlue =  (   ( d         & mask ) *  ( 255 - a ) + b * a ) >> 8;
-
-			// pack channels back into pixel and fire pixel onto surface
-			*i = ( rsltRed << 16 ) | ( rsltGreen << 8 ) | rsltBlue;
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::PerPixelAlpha,Pixel::Scalar >( s );
 	}
 	void BlendAlphaPremultipliedPacked( Surface& s )
 	{
-		const unsigned int mask = 0xFF;
-		for( Color* i = buffer,*end = &buffer[pixelPitch * height],*j = s.GetBuffer();
-			i < end; i++,j++ )
-		{
-			// load (premultiplied) source and destination pixels
-			const Color d = *i;
-			const Color s = *j;
-
-			// extract alpha complement
-			const unsigned int ca = s >> 24;
-
-			// unpack source components and blend channels
-			const unsigned int rsltRed =   ( ( ( d >> 16 ) & mask ) * ca ) >> 8;
-			const unsigned int rsltGreen = ( ( ( d >> 8  ) & mask ) * ca ) >> 8;
-			const unsigned int rsltBlue =  (   ( d         & mask ) * ca ) >> 8;
-
-			// pack channels back into pixel, add premultiplied packed components, and fire pixel onto surface
-			*i = ( ( rsltRed << 16 ) | ( rsltGreen << 8 ) | rsltBlue ) + s;
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::Premultiplied,Pixel::Scalar >( s );
 	}
 	void DrawRect( RectI& rect,Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity( rect );
 		for( unsigned int y = unsigned int( rect.top ); y < unsigned int( rect.bottom ); y++ )
 		{
 			for( Color* i = &buffer[y * width + unsigned int( rect.left )],*end = i + rect.GetWidth();
@@ -498,6 +483,8 @@ public:
 	}
 	void DrawRectBlendPrecomputedPacked( RectI& rect,Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity( rect );
 		// unpack and premultiply tint channels
 		const unsigned int rPrecomp = ( c.r * c.x ) >> 8;
 		const unsigned int gPrecomp = ( c.g * c.x ) >> 8;
@@ -526,6 +513,8 @@ public:
 	}
 	void DrawRectBlendHalfPacked( RectI& rect,Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity( rect );
 		const unsigned int shiftMask = 0x007F7F7F;
 		const Color preComp = ( c >> 1 ) & shiftMask;
 		for( unsigned int y = unsigned int( rect.top ); y < unsigned int( rect.bottom ); y++ )
@@ -539,154 +528,40 @@ public:
 	}
 	void Blt( Vei2 dstPt,RectI& srcRect,Surface& src )
 	{
-		for( int yDst = dstPt.y, 
-			yDstEnd = yDst + srcRect.GetHeight(),
-			ySrc = srcRect.top;
-			yDst < yDstEnd; yDst++,ySrc++ )
-		{
-			for( Color* i = &buffer[yDst * width + dstPt.x],
-				*iEnd = i + srcRect.GetWidth(),
-				*j = &src.GetBuffer()[ySrc * (int)src.GetPixelPitch() + srcRect.left];
-				i < iEnd; i++,j++ )
-			{
-				*i = *j;
-			}
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::Copy,Pixel::Scalar >( dstPt,srcRect,src );
 	}
 	void BltBlend( Vei2 dstPt,RectI& srcRect,Surface& src,unsigned char alpha )
 	{
-		const unsigned int mask = 0xFF;
-		const unsigned int a = alpha;
-		for( int yDst = dstPt.y,
-			yDstEnd = yDst + srcRect.GetHeight(),
-			ySrc = srcRect.top;
-			yDst < yDstEnd; yDst++,ySrc++ )
-		{
-			for( Color* i = &buffer[yDst * width + dstPt.x],
-				*iEnd = i + srcRect.GetWidth(),
-				*j = &src.GetBuffer()[ySrc * (int)src.GetPixelPitch() + srcRect.left];
-				i < iEnd; i++,j++ )
-			{
-				// load source and destination pixels
-				const Color d = *i;
-				const Color s = *j;
-
-				// unpack source components
-				const unsigned int r = ( s >> 16 ) & mask;
-				const unsigned int g = ( s >> 8  ) & mask;
-				const unsigned int b =   s         & mask;
-
-				// unpack source components and blend channels
-				const unsigned int rsltRed =   ( ( ( d >> 16 ) & mask ) * ( 255 - a ) + r * a ) >> 8;
-				const unsigned int rsltGreen = ( ( ( d >> 8  ) & mask ) * ( 255 - a ) + g * a ) >> 8;
-				const unsigned int rsltBlue =  (   ( d         & mask ) * ( 255 - a ) + b * a ) >> 8;
-
-				// pack channels back into pixel and fire pixel onto surface
-				*i = ( rsltRed << 16 ) | ( rsltGreen << 8 ) | rsltBlue;
-			}
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::ConstantAlpha,Pixel::Scalar >( dstPt,srcRect,src,Pixel::ConstantAlpha( alpha ) );
 	}
 	void BltBlendHalfPacked( Vei2 dstPt,RectI& srcRect,Surface& src )
 	{
-		const unsigned int shiftMask = 0x007F7F7F;
-		for( int yDst = dstPt.y,
-			yDstEnd = yDst + srcRect.GetHeight(),
-			ySrc = srcRect.top;
-			yDst < yDstEnd; yDst++,ySrc++ )
-		{
-			for( Color* i = &buffer[yDst * width + dstPt.x],
-				*iEnd = i + srcRect.GetWidth(),
-				*j = &src.GetBuffer()[ySrc * (int)src.GetPixelPitch() + srcRect.left];
-				i < iEnd; i++,j++ )
-			{
-				// divide source and destination channels by 2 and sum (no carry will happen)
-				*i = ( ( *i >> 1 ) & shiftMask ) + ( ( *j >> 1 ) & shiftMask );
-			}
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::HalfAverage,Pixel::Scalar >( dstPt,srcRect,src );
 	}
 	void BltAlpha( Vei2 dstPt,RectI& srcRect,Surface& src )
 	{
-		const unsigned int mask = 0xFF;
-		for( int yDst = dstPt.y,
-			yDstEnd = yDst + srcRect.GetHeight(),
-			ySrc = srcRect.top;
-			yDst < yDstEnd; yDst++,ySrc++ )
-		{
-			for( Color* i = &buffer[yDst * width + dstPt.x],
-				*iEnd = i + srcRect.GetWidth(),
-				*j = &src.GetBuffer()[ySrc * (int)src.GetPixelPitch() + srcRect.left];
-				i < iEnd; i++,j++ )
-			{
-				// load source and destination pixels
-				const Color d = *i;
-				const Color s = *j;
-
-				// unpack source components
-				const unsigned int a =   s >> 24;
-				const unsigned int r = ( s >> 16 ) & mask;
-				const unsigned int g = ( s >> 8  ) & mask;
-				const unsigned int b =   s         & mask;
-
-				// unpack source components and blend channels
-				const unsigned int rsltRed =   ( ( ( d >> 16 ) & mask ) *  ( 255 - a ) + r * a ) >> 8;
-				const unsigned int rsltGreen = ( ( ( d >> 8  ) & mask ) *  ( 255 - a ) + g * a ) >> 8;
-				const unsigned int rsltBlue =  (   ( d         & mask ) *  ( 255 - a ) + b * a ) >> 8;
-
-				// pack channels back into pixel and fire pixel onto surface
-				*i = ( rsltRed << 16 ) | ( rsltGreen << 8 ) | rsltBlue;
-			}
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::PerPixelAlpha,Pixel::Scalar >( dstPt,srcRect,src );
 	}
 	void BltAlphaPremultipliedPacked( Vei2 dstPt,RectI& srcRect,Surface& src )
 	{
-		const unsigned int mask = 0xFF;
-		for( int yDst = dstPt.y,
-			yDstEnd = yDst + srcRect.GetHeight(),
-			ySrc = srcRect.top;
-			yDst < yDstEnd; yDst++,ySrc++ )
-		{
-			for( Color* i = &buffer[yDst * width + dstPt.x],
-				*iEnd = i + srcRect.GetWidth(),
-				*j = &src.GetBuffer()[ySrc * (int)src.GetPixelPitch() + srcRect.left];
-				i < iEnd; i++,j++ )
-			{
-				// load (premultiplied) source and destination pixels
-				const Color d = *i;
-				const Color s = *j;
-
-				// calculate alpha complement
-				const unsigned int ca = 255 - (s >> 24);
-
-				// unpack source components and blend channels
-				const unsigned int rsltRed =   ( ( ( d >> 16 ) & mask ) * ca ) >> 8;
-				const unsigned int rsltGreen = ( ( ( d >> 8  ) & mask ) * ca ) >> 8;
-				const unsigned int rsltBlue =  ( (   d         & mask ) * ca ) >> 8;
-
-				// pack channels back into pixel, add premultiplied packed components, and fire pixel onto surface
-				*i = ( ( rsltRed << 16 ) | ( rsltGreen << 8 ) | rsltBlue ) + s;
-			}
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::Premultiplied,Pixel::Scalar >( dstPt,srcRect,src );
 	}
 	void BltKey( Vei2 dstPt,RectI& srcRect,Surface& src,Color key )
 	{
-		for( int yDst = dstPt.y,
-			yDstEnd = yDst + srcRect.GetHeight(),
-			ySrc = srcRect.top;
-			yDst < yDstEnd; yDst++,ySrc++ )
-		{
-			for( Color* i = &buffer[yDst * width + dstPt.x],
-				*iEnd = i + srcRect.GetWidth(),
-				*j = &src.GetBuffer()[ySrc * (int)src.GetPixelPitch() + srcRect.left];
-				i < iEnd; i++,j++ )
-			{
-				*i = ( *j == key ? *i : *j );
-			}
-		}
+		PROFILE_FUNCTION();
+		Compose< Pixel::ColorKey,Pixel::Scalar >( dstPt,srcRect,src,Pixel::ColorKey( key ) );
 	}
 	//////////////////////////////////
 	// Bench Functions (SSE)
 	void ClearSSE()
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		__m128i zero = _mm_setzero_si128();
 		for( __m128i* i = reinterpret_cast<__m128i*>( buffer ),
 			*end = reinterpret_cast<__m128i*>( &buffer[pixelPitch * height] );
@@ -697,6 +572,8 @@ public:
 	}
 	void FillSSE( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const __m128i color = _mm_set1_epi32( c );
 		for( __m128i* i = reinterpret_cast<__m128i*>( buffer ),
 			*end = reinterpret_cast<__m128i*>( &buffer[pixelPitch * height] );
@@ -707,6 +584,8 @@ public:
 	}
 	void FadeSSE( unsigned char a )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const __m128i alpha = _mm_set1_epi16( a );
 		const __m128i zero = _mm_setzero_si128();
 		for( __m128i* i = reinterpret_cast<__m128i*>( buffer ),
@@ -725,6 +604,8 @@ public:
 	}
 	void FadeHalfSSE()
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const __m128i zero = _mm_setzero_si128();
 		for( __m128i* i = reinterpret_cast<__m128i*>( buffer ),
 			*end = reinterpret_cast<__m128i*>( &buffer[pixelPitch * height] );
@@ -740,6 +621,8 @@ public:
 	}
 	void FadeHalfPackedSSE()
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const __m128i shiftMask = _mm_set1_epi8( 0x7F );
 		for( __m128i* i = reinterpret_cast<__m128i*>( buffer ),
 			*end = reinterpret_cast<__m128i*>( &buffer[pixelPitch * height] );
@@ -753,6 +636,8 @@ public:
 	}
 	void FadeHalfAvgSSE()
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const __m128i zero = _mm_setzero_si128();
 		for( __m128i* i = reinterpret_cast<__m128i*>( buffer ),
 			*end = reinterpret_cast<__m128i*>( &buffer[pixelPitch * height] );
@@ -764,6 +649,8 @@ public:
 	}
 	void TintSSE( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const __m128i zero = _mm_setzero_si128();
 		const __m128i ones = _mm_set1_epi16( 0x00FF );
 		const __m128i color = _mm_set1_epi32( c );
@@ -790,6 +677,8 @@ public:
 	}
 	void TintPrecomputedSSE( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const __m128i zero = _mm_setzero_si128();
 		const __m128i alpha = _mm_set1_epi16( c.x );
 		const __m128i calpha = _mm_sub_epi16( _mm_set1_epi16( 0x00FF ),alpha );
@@ -816,6 +705,8 @@ public:
 	}
 	void TintHalfAvgSSE( Color c )
 	{
+		PROFILE_FUNCTION();
+		InvalidateOpacity();
 		const __m128i color = _mm_set1_epi32( c );
 		for( __m128i* i = reinterpret_cast<__m128i*>( buffer ),
 			*end = reinterpret_cast<__m128i*>( &buffer[pixelPitch * height] );
@@ -826,6 +717,277 @@ public:
 			_mm_store_si128( i,rslt );
 		}
 	}
+	void BlendSSE( Surface& s,unsigned char alpha )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::ConstantAlpha,Pixel::SSE2 >( s,Pixel::ConstantAlpha( alpha ) );
+	}
+	void BlendHalfSSE( Surface& s )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::HalfAverage,Pixel::SSE2 >( s );
+	}
+	void BlendAlphaSSE( Surface& s )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::PerPixelAlpha,Pixel::SSE2 >( s );
+	}
+	void BlendAlphaPremultipliedSSE( Surface& s )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::Premultiplied,Pixel::SSE2 >( s );
+	}
+	void BltSSE( Vei2 dstPt,RectI& srcRect,Surface& src )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::Copy,Pixel::SSE2 >( dstPt,srcRect,src );
+	}
+	void BltBlendSSE( Vei2 dstPt,RectI& srcRect,Surface& src,unsigned char alpha )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::ConstantAlpha,Pixel::SSE2 >( dstPt,srcRect,src,Pixel::ConstantAlpha( alpha ) );
+	}
+	void BltAlphaSSE( Vei2 dstPt,RectI& srcRect,Surface& src )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::PerPixelAlpha,Pixel::SSE2 >( dstPt,srcRect,src );
+	}
+	void BltAlphaPremultipliedSSE( Vei2 dstPt,RectI& srcRect,Surface& src )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::Premultiplied,Pixel::SSE2 >( dstPt,srcRect,src );
+	}
+	void BltKeySSE( Vei2 dstPt,RectI& srcRect,Surface& src,Color key )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::ColorKey,Pixel::SSE2 >( dstPt,srcRect,src,Pixel::ColorKey( key ) );
+	}
+	// per-pixel alpha blended in linear light for gamma-correct edges; several times the
+	// cost of BlendAlphaSSE since every channel goes through the sRGB tables (see -roofline)
+	void BlendAlphaLinear( Surface& s )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::LinearAlpha,Pixel::SSE2 >( s );
+	}
+	void BltAlphaLinear( Vei2 dstPt,RectI& srcRect,Surface& src )
+	{
+		PROFILE_FUNCTION();
+		Compose< Pixel::LinearAlpha,Pixel::SSE2 >( dstPt,srcRect,src );
+	}
+	//////////////////////////////////
+	// Pixel Pipeline
+	// composite src over the whole surface with any blend mode / ISA from PixelPipeline.h
+	// (not profiled: callers like particle draws issue thousands of these per frame)
+	template< class Mode,class Isa = Pixel::SSE2 >
+	void Compose( const Surface& src,const Mode& mode = Mode() )
+	{
+		assert( width == src.width );
+		assert( height == src.height );
+		InvalidateOpacity();
+		if( src.HasOpacityTiles() )
+		{
+			// goes through the rect path so alpha modes can use the tile summary
+			const RectI srcRect( 0,(int)width,0,(int)height );
+			ComposeRect< Isa >( { 0,0 },srcRect,src,mode );
+		}
+		else if( pixelPitch == src.pixelPitch )
+		{
+			Pixel::Row< Mode,Isa >::Run( buffer,src.buffer,pixelPitch * height,mode );
+		}
+		else
+		{
+			for( unsigned int y = 0; y < height; y++ )
+			{
+				Pixel::Row< Mode,Isa >::Run( &buffer[pixelPitch * y],&src.buffer[src.pixelPitch * y],width,mode );
+			}
+		}
+	}
+	// composite srcRect of src with its top left at dstPt (no clipping)
+	template< class Mode,class Isa = Pixel::SSE2 >
+	void Compose( Vei2 dstPt,const RectI& srcRect,const Surface& src,const Mode& mode = Mode() )
+	{
+		assert( dstPt.x >= 0 && dstPt.x + srcRect.GetWidth() <= (int)width );
+		assert( dstPt.y >= 0 && dstPt.y + srcRect.GetHeight() <= (int)height );
+		InvalidateOpacity( RectI( dstPt.x,dstPt.x + srcRect.GetWidth(),dstPt.y,dstPt.y + srcRect.GetHeight() ) );
+		ComposeRect< Isa >( dstPt,srcRect,src,mode );
+	}
+	//////////////////////////////////
+	// Opacity Tiles
+	// optional coarse summary of the alpha channel per 32x32 tile, so alpha compositing
+	// can skip transparent tiles of a source and plain copy its opaque ones
+	// every write made through Surface marks the tiles it touches dirty; dirty tiles are
+	// treated as mixed until UpdateOpacityTiles recomputes them
+	// the tile bytes are plain memory: concurrent writes into one tiled Surface are only
+	// safe when each thread covers its own rows of tiles (SpriteBatch aligns its bands to
+	// them), and whole-surface writes must not overlap any other access
+	enum TileOpacity : unsigned char
+	{
+		TileDirty,
+		TileTransparent,
+		TileOpaque,
+		TileMixed
+	};
+	static const unsigned int opacityTileShift = 5;
+	void EnableOpacityTiles()
+	{
+		nTilesX = ( width + ( 1 << opacityTileShift ) - 1 ) >> opacityTileShift;
+		nTilesY = ( height + ( 1 << opacityTileShift ) - 1 ) >> opacityTileShift;
+		opacityTiles.assign( nTilesX * nTilesY,TileDirty );
+		UpdateOpacityTiles();
+	}
+	void DisableOpacityTiles()
+	{
+		opacityTiles.clear();
+		nTilesX = 0;
+		nTilesY = 0;
+	}
+	inline bool HasOpacityTiles() const
+	{
+		return !opacityTiles.empty();
+	}
+	// recompute the dirty tiles
+	void UpdateOpacityTiles()
+	{
+		PROFILE_FUNCTION();
+		for( unsigned int ty = 0; ty < nTilesY; ty++ )
+		{
+			for( unsigned int tx = 0; tx < nTilesX; tx++ )
+			{
+				unsigned char& tile = opacityTiles[ty * nTilesX + tx];
+				if( tile == TileDirty )
+				{
+					tile = ClassifyTile( tx,ty );
+				}
+			}
+		}
+	}
+	inline TileOpacity GetTileOpacity( unsigned int tx,unsigned int ty ) const
+	{
+		assert( tx < nTilesX );
+		assert( ty < nTilesY );
+		return TileOpacity( opacityTiles[ty * nTilesX + tx] );
+	}
+protected:
+	void InvalidateOpacity()
+	{
+		if( !opacityTiles.empty() )
+		{
+			opacityTiles.assign( opacityTiles.size(),TileDirty );
+		}
+	}
+	void InvalidateOpacity( const RectI& rect )
+	{
+		if( opacityTiles.empty() || rect.GetWidth() <= 0 || rect.GetHeight() <= 0 )
+		{
+			return;
+		}
+		for( unsigned int ty = unsigned( rect.top ) >> opacityTileShift,
+			tyEnd = unsigned( rect.bottom - 1 ) >> opacityTileShift; ty <= tyEnd; ty++ )
+		{
+			for( unsigned int tx = unsigned( rect.left ) >> opacityTileShift,
+				txEnd = unsigned( rect.right - 1 ) >> opacityTileShift; tx <= txEnd; tx++ )
+			{
+				opacityTiles[ty * nTilesX + tx] = TileDirty;
+			}
+		}
+	}
+private:
+	// ORs and ANDs the tile's pixels four at a time; transparent when no alpha bit is
+	// set in the OR, opaque when every alpha bit is set in the AND
+	TileOpacity ClassifyTile( unsigned int tx,unsigned int ty ) const
+	{
+		const unsigned int x0 = tx << opacityTileShift;
+		const unsigned int x1 = x0 + ( 1 << opacityTileShift ) < width ? x0 + ( 1 << opacityTileShift ) : width;
+		const unsigned int y0 = ty << opacityTileShift;
+		const unsigned int y1 = y0 + ( 1 << opacityTileShift ) < height ? y0 + ( 1 << opacityTileShift ) : height;
+		const __m128i alphaMask = _mm_set1_epi32( 0xFF000000 );
+		__m128i any = _mm_setzero_si128();
+		__m128i all = alphaMask;
+		unsigned int anyScalar = 0;
+		unsigned int allScalar = 0xFF000000;
+		for( unsigned int y = y0; y < y1; y++ )
+		{
+			const Color* p = &buffer[y * pixelPitch + x0];
+			const Color* const end = p + ( x1 - x0 );
+			for( ; p + 4 <= end; p += 4 )
+			{
+				const __m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+				any = _mm_or_si128( any,pixels );
+				all = _mm_and_si128( all,pixels );
+			}
+			for( ; p < end; p++ )
+			{
+				anyScalar |= *p;
+				allScalar &= *p;
+			}
+			// stop as soon as the tile is known to be mixed
+			const bool hasAlpha = ( _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( any,alphaMask ),
+				_mm_setzero_si128() ) ) != 0xFFFF ) || ( anyScalar & 0xFF000000 ) != 0;
+			const bool allOpaque = _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( all,alphaMask ),
+				alphaMask ) ) == 0xFFFF && ( allScalar & 0xFF000000 ) == 0xFF000000;
+			if( hasAlpha && !allOpaque )
+			{
+				return TileMixed;
+			}
+		}
+		const bool hasAlpha = ( _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( any,alphaMask ),
+			_mm_setzero_si128() ) ) != 0xFFFF ) || ( anyScalar & 0xFF000000 ) != 0;
+		return hasAlpha ? TileOpaque : TileTransparent;
+	}
+	template< class Isa,class Mode >
+	void ComposeRect( Vei2 dstPt,const RectI& srcRect,const Surface& src,const Mode& mode )
+	{
+		const unsigned int rowWidth = srcRect.GetWidth();
+		for( int yDst = dstPt.y,
+			yDstEnd = yDst + srcRect.GetHeight(),
+			ySrc = srcRect.top;
+			yDst < yDstEnd; yDst++,ySrc++ )
+		{
+			Pixel::Row< Mode,Isa >::Run( &buffer[yDst * (int)pixelPitch + dstPt.x],
+				&src.buffer[ySrc * (int)src.pixelPitch + srcRect.left],rowWidth,mode );
+		}
+	}
+	// per-pixel alpha: transparent source tiles are skipped and opaque ones copied
+	// (also exact where the / 256 lerp would be off by one at alpha 0 and 255)
+	template< class Isa >
+	void ComposeRect( Vei2 dstPt,const RectI& srcRect,const Surface& src,const Pixel::PerPixelAlpha& mode )
+	{
+		if( !src.HasOpacityTiles() )
+		{
+			ComposeRect< Isa,Pixel::PerPixelAlpha >( dstPt,srcRect,src,mode );
+			return;
+		}
+		const int tileSize = 1 << opacityTileShift;
+		for( int ty = srcRect.top >> opacityTileShift; ty * tileSize < srcRect.bottom; ty++ )
+		{
+			const int y0 = ty * tileSize > srcRect.top ? ty * tileSize : srcRect.top;
+			const int y1 = ( ty + 1 ) * tileSize < srcRect.bottom ? ( ty + 1 ) * tileSize : srcRect.bottom;
+			for( int tx = srcRect.left >> opacityTileShift; tx * tileSize < srcRect.right; tx++ )
+			{
+				const TileOpacity opacity = src.GetTileOpacity( tx,ty );
+				if( opacity == TileTransparent )
+				{
+					continue;
+				}
+				const int x0 = tx * tileSize > srcRect.left ? tx * tileSize : srcRect.left;
+				const int x1 = ( tx + 1 ) * tileSize < srcRect.right ? ( tx + 1 ) * tileSize : srcRect.right;
+				for( int y = y0; y < y1; y++ )
+				{
+					Color* const pDst = &buffer[( dstPt.y + y - srcRect.top ) * (int)pixelPitch +
+						dstPt.x + x0 - srcRect.left];
+					const Color* const pSrc = &src.buffer[y * (int)src.pixelPitch + x0];
+					if( opacity == TileOpaque )
+					{
+						memcpy( pDst,pSrc,( x1 - x0 ) * sizeof( Color ) );
+					}
+					else
+					{
+						Pixel::Row< Pixel::PerPixelAlpha,Isa >::Run( pDst,pSrc,x1 - x0,mode );
+					}
+				}
+			}
+		}
+	}
 private:
 	static unsigned int CalculatePixelPitch( unsigned int width,unsigned int byteAlignment )
 	{
@@ -833,11 +995,46 @@ private:
 		const unsigned int pixelAlignment = byteAlignment / sizeof( Color );
 		return width + ( pixelAlignment - width % pixelAlignment ) % pixelAlignment;
 	}
+	// enumerating the GDI+ encoders is slow, so it happens on the first Save only
+	static const CLSID& GetBmpEncoderClsid()
+	{
+		static const struct BmpEncoder
+		{
+			BmpEncoder()
+			{
+				memset( &clsid,0,sizeof( clsid ) );
+				UINT num = 0;
+				UINT size = 0;
+				Gdiplus::GetImageEncodersSize( &num,&size );
+				if( size == 0 )
+				{
+					return;
+				}
+				std::vector<BYTE> codecs( size );
+				Gdiplus::ImageCodecInfo* const pCodecs = reinterpret_cast<Gdiplus::ImageCodecInfo*>( codecs.data() );
+				Gdiplus::GetImageEncoders( num,size,pCodecs );
+				for( UINT i = 0; i < num; i++ )
+				{
+					if( wcscmp( pCodecs[i].MimeType,L"image/bmp" ) == 0 )
+					{
+						clsid = pCodecs[i].Clsid;
+						return;
+					}
+				}
+			}
+			CLSID clsid;
+		} encoder;
+		return encoder.clsid;
+	}
 protected:
 	Color* buffer;
 	unsigned int width;
 	unsigned int height;
 	unsigned int pixelPitch;
+	// one TileOpacity per tile, empty when disabled
+	std::vector<unsigned char> opacityTiles;
+	unsigned int nTilesX;
+	unsigned int nTilesY;
 };
 
 class TextSurface : public Surface
@@ -858,6 +1055,7 @@ public:
 		Gdiplus::SolidBrush textBrush( textColor );
 		g.DrawString( string.c_str(),-1,font,
 			Gdiplus::PointF( pt.x,pt.y ),&textBrush );
+		InvalidateOpacity();
 	}
 	void DrawString( const std::wstring& string,const RectF& rect,const Font& font,
 		Color c = WHITE,Font::Alignment a = Font::Center )
@@ -882,6 +1080,7 @@ public:
 			Gdiplus::RectF( rect.left,rect.top,rect.GetWidth(),rect.GetHeight() ),
 			&format,
 			&textBrush );
+		InvalidateOpacity();
 	}
 	TextSurface( const TextSurface& ) = delete;
 	TextSurface( TextSurface&& ) = delete;
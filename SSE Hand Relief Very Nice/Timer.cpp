@@ -23,7 +23,6 @@
 
 Timer::Timer()
 {
-	unsigned long long frequency;
 	QueryPerformanceFrequency( (LARGE_INTEGER*)&frequency );
 	invFreqMilli = 1.0f / (float)((double)frequency / 1000.0);
 	StartWatch();
@@ -60,4 +59,18 @@ float Timer::GetTimeMilli() const
 	{
 		return (float)(currentCount - startCount) * invFreqMilli;
 	}
+}
+
+unsigned long long Timer::GetTicks() const
+{
+	if( !watchStopped )
+	{
+		QueryPerformanceCounter( (LARGE_INTEGER*)&currentCount );
+	}
+	return currentCount - startCount;
+}
+
+unsigned long long Timer::GetFrequency() const
+{
+	return frequency;
 }
\ No newline at end of file
@@ -30,7 +30,11 @@ public:
 	void StopWatch();
 	float GetTimeMilli() const;
 	float GetTimeSec() const;
+	// raw performance counter ticks (exact, use these to accumulate over long runs)
+	unsigned long long GetTicks() const;
+	unsigned long long GetFrequency() const;
 private:
+	unsigned long long frequency;
 	float invFreqMilli;
 	bool watchStopped;
 	unsigned long long currentCount;
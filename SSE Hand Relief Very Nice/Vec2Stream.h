@@ -0,0 +1,234 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	Vec2Stream.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include <emmintrin.h>
+
+namespace StreamDetail
+{
+	// reallocate a 16-byte aligned float array, keeping the first size elements and
+	// zeroing the rest (so padding lanes hold harmless values)
+	inline float* Grow( float* p,unsigned int size,unsigned int newCapacity )
+	{
+		float* const pNew = (float*)_mm_malloc( newCapacity * sizeof( float ),16 );
+		if( p != nullptr )
+		{
+			memcpy( pNew,p,size * sizeof( float ) );
+			_mm_free( p );
+		}
+		memset( pNew + size,0,( newCapacity - size ) * sizeof( float ) );
+		return pNew;
+	}
+	// capacities are always a multiple of 4 so whole __m128 groups can be processed
+	inline unsigned int PadCapacity( unsigned int n )
+	{
+		return ( n + 3 ) & ~3u;
+	}
+}
+
+// structure-of-arrays batch of float vectors; all operations process four vectors per
+// SSE instruction (the padding lanes past Size() are kept finite and ignored)
+class Vec2Stream
+{
+public:
+	Vec2Stream( unsigned int capacity = 0 )
+		:
+		x( nullptr ),
+		y( nullptr ),
+		size( 0 ),
+		capacity( 0 )
+	{
+		Reserve( capacity );
+	}
+	Vec2Stream( const Vec2Stream& ) = delete;
+	Vec2Stream& operator=( const Vec2Stream& ) = delete;
+	~Vec2Stream()
+	{
+		_mm_free( x );
+		_mm_free( y );
+	}
+	void Reserve( unsigned int n )
+	{
+		n = StreamDetail::PadCapacity( n );
+		if( n > capacity )
+		{
+			x = StreamDetail::Grow( x,size,n );
+			y = StreamDetail::Grow( y,size,n );
+			capacity = n;
+		}
+	}
+	void Push( Vec2 v )
+	{
+		if( size == capacity )
+		{
+			Reserve( capacity != 0 ? capacity * 2 : 16 );
+		}
+		x[size] = v.x;
+		y[size] = v.y;
+		size++;
+	}
+	inline Vec2 Get( unsigned int i ) const
+	{
+		assert( i < size );
+		return { x[i],y[i] };
+	}
+	inline void Set( unsigned int i,Vec2 v )
+	{
+		assert( i < size );
+		x[i] = v.x;
+		y[i] = v.y;
+	}
+	inline unsigned int Size() const
+	{
+		return size;
+	}
+	void Clear()
+	{
+		memset( x,0,capacity * sizeof( float ) );
+		memset( y,0,capacity * sizeof( float ) );
+		size = 0;
+	}
+	inline float* X()
+	{
+		return x;
+	}
+	inline float* Y()
+	{
+		return y;
+	}
+	inline const float* X() const
+	{
+		return x;
+	}
+	inline const float* Y() const
+	{
+		return y;
+	}
+	// v = xAxis * v.x + yAxis * v.y + offset
+	void Transform( Vec2 xAxis,Vec2 yAxis,Vec2 offset )
+	{
+		const __m128 m00 = _mm_set1_ps( xAxis.x );
+		const __m128 m10 = _mm_set1_ps( xAxis.y );
+		const __m128 m01 = _mm_set1_ps( yAxis.x );
+		const __m128 m11 = _mm_set1_ps( yAxis.y );
+		const __m128 tx = _mm_set1_ps( offset.x );
+		const __m128 ty = _mm_set1_ps( offset.y );
+		for( unsigned int i = 0; i < size; i += 4 )
+		{
+			const __m128 vx = _mm_load_ps( x + i );
+			const __m128 vy = _mm_load_ps( y + i );
+			_mm_store_ps( x + i,_mm_add_ps( _mm_add_ps( _mm_mul_ps( vx,m00 ),_mm_mul_ps( vy,m01 ) ),tx ) );
+			_mm_store_ps( y + i,_mm_add_ps( _mm_add_ps( _mm_mul_ps( vx,m10 ),_mm_mul_ps( vy,m11 ) ),ty ) );
+		}
+	}
+	void Translate( Vec2 d )
+	{
+		Transform( { 1.0f,0.0f },{ 0.0f,1.0f },d );
+	}
+	void Scale( float s )
+	{
+		Transform( { s,0.0f },{ 0.0f,s },{ 0.0f,0.0f } );
+	}
+	// one sin/cos for the whole batch (_Vec2::Rotation pays for both per vector)
+	void Rotate( float angle )
+	{
+		const float cosine = cosf( angle );
+		const float sine = sinf( angle );
+		Transform( { cosine,sine },{ -sine,cosine },{ 0.0f,0.0f } );
+	}
+	// rsqrt estimate refined by one Newton-Raphson step (~22 bits); zero vectors stay zero
+	void Normalize()
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 half = _mm_set1_ps( 0.5f );
+		const __m128 threeHalves = _mm_set1_ps( 1.5f );
+		for( unsigned int i = 0; i < size; i += 4 )
+		{
+			const __m128 vx = _mm_load_ps( x + i );
+			const __m128 vy = _mm_load_ps( y + i );
+			const __m128 lenSq = _mm_add_ps( _mm_mul_ps( vx,vx ),_mm_mul_ps( vy,vy ) );
+			__m128 invLen = _mm_rsqrt_ps( lenSq );
+			invLen = _mm_mul_ps( invLen,_mm_sub_ps( threeHalves,
+				_mm_mul_ps( _mm_mul_ps( half,lenSq ),_mm_mul_ps( invLen,invLen ) ) ) );
+			// rsqrt( 0 ) is inf, which would turn zero vectors into NaN
+			invLen = _mm_and_ps( invLen,_mm_cmpgt_ps( lenSq,zero ) );
+			_mm_store_ps( x + i,_mm_mul_ps( vx,invLen ) );
+			_mm_store_ps( y + i,_mm_mul_ps( vy,invLen ) );
+		}
+	}
+	// out[i] = this[i] * rhs[i] (out must hold Size() floats)
+	void Dot( const Vec2Stream& rhs,float* out ) const
+	{
+		assert( rhs.size == size );
+		unsigned int i = 0;
+		for( ; i + 4 <= size; i += 4 )
+		{
+			_mm_storeu_ps( out + i,_mm_add_ps(
+				_mm_mul_ps( _mm_load_ps( x + i ),_mm_load_ps( rhs.x + i ) ),
+				_mm_mul_ps( _mm_load_ps( y + i ),_mm_load_ps( rhs.y + i ) ) ) );
+		}
+		for( ; i < size; i++ )
+		{
+			out[i] = x[i] * rhs.x[i] + y[i] * rhs.y[i];
+		}
+	}
+	// out[i] = this[i] * v
+	void Dot( Vec2 v,float* out ) const
+	{
+		const __m128 vx = _mm_set1_ps( v.x );
+		const __m128 vy = _mm_set1_ps( v.y );
+		unsigned int i = 0;
+		for( ; i + 4 <= size; i += 4 )
+		{
+			_mm_storeu_ps( out + i,_mm_add_ps(
+				_mm_mul_ps( _mm_load_ps( x + i ),vx ),_mm_mul_ps( _mm_load_ps( y + i ),vy ) ) );
+		}
+		for( ; i < size; i++ )
+		{
+			out[i] = x[i] * v.x + y[i] * v.y;
+		}
+	}
+	// out[i] = this[i].CrossWith( rhs[i] )
+	void Cross( const Vec2Stream& rhs,float* out ) const
+	{
+		assert( rhs.size == size );
+		unsigned int i = 0;
+		for( ; i + 4 <= size; i += 4 )
+		{
+			_mm_storeu_ps( out + i,_mm_sub_ps(
+				_mm_mul_ps( _mm_load_ps( x + i ),_mm_load_ps( rhs.y + i ) ),
+				_mm_mul_ps( _mm_load_ps( y + i ),_mm_load_ps( rhs.x + i ) ) ) );
+		}
+		for( ; i < size; i++ )
+		{
+			out[i] = x[i] * rhs.y[i] - y[i] * rhs.x[i];
+		}
+	}
+private:
+	float* x;
+	float* y;
+	unsigned int size;
+	unsigned int capacity;
+};
\ No newline at end of file
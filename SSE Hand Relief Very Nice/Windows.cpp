@@ -24,10 +24,40 @@
 #include "Game.h"
 #include "resource.h"
 #include "Mouse.h"
+#include "InputRecorder.h"
+#include "HeadlessRunner.h"
+#include "Roofline.h"
+#include "ParticleSystem.h"
+#include "ColorLut.h"
+#include "FrameDelta.h"
+#include "FrameExport.h"
+#include <fstream>
+#include <memory>
 
 static KeyboardServer kServ;
 static MouseServer mServ;
 
+// returns the (space free) argument following the switch sw, or empty if sw is absent
+static std::wstring GetSwitchArg( const wchar_t* pCmdLine,const wchar_t* sw )
+{
+	const wchar_t* pArg = wcsstr( pCmdLine,sw );
+	if( pArg == nullptr )
+	{
+		return std::wstring();
+	}
+	pArg += wcslen( sw );
+	while( *pArg == L' ' )
+	{
+		pArg++;
+	}
+	const wchar_t* pEnd = pArg;
+	while( *pEnd != L'\0' && *pEnd != L' ' )
+	{
+		pEnd++;
+	}
+	return std::wstring( pArg,pEnd );
+}
+
 LRESULT WINAPI MsgProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam )
 {
     switch( msg )
@@ -133,8 +163,50 @@ LRESULT WINAPI MsgProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam )
     return DefWindowProc( hWnd, msg, wParam, lParam );
 }
 
-int WINAPI wWinMain( HINSTANCE hInst,HINSTANCE,LPWSTR,INT )
+int WINAPI wWinMain( HINSTANCE hInst,HINSTANCE,LPWSTR pCmdLine,INT )
 {
+	// "-replay <file>" runs the recording headless and exits without ever opening a window
+	const std::wstring replayFile = GetSwitchArg( pCmdLine,L"-replay" );
+	if( !replayFile.empty() )
+	{
+		std::wofstream report( L"replay.txt" );
+		return RunHeadless( replayFile,report );
+	}
+
+	// "-roofline" calibrates the machine, rates every Surface kernel against it and exits
+	if( wcsstr( pCmdLine,L"-roofline" ) != nullptr )
+	{
+		std::wofstream report( L"roofline.txt" );
+		Roofline().Run( report );
+		return 0;
+	}
+
+	// "-particles" benchmarks the particle system from 1k to 1M particles and exits
+	if( wcsstr( pCmdLine,L"-particles" ) != nullptr )
+	{
+		std::wofstream report( L"particles.txt" );
+		ParticleSystem::Benchmark( report );
+		return 0;
+	}
+
+	// "-colorlut" times the colour grading pass on a 720p frame and exits
+	if( wcsstr( pCmdLine,L"-colorlut" ) != nullptr )
+	{
+		std::wofstream report( L"colorlut.txt" );
+		ColorLut::Benchmark( report );
+		return 0;
+	}
+
+	// "-record <file>" captures all input with frame markers for later replay
+	std::unique_ptr<InputRecorder> pRecorder;
+	const std::wstring recordFile = GetSwitchArg( pCmdLine,L"-record" );
+	if( !recordFile.empty() )
+	{
+		pRecorder.reset( new InputRecorder( recordFile ) );
+		kServ.SetRecorder( pRecorder.get() );
+		mServ.SetRecorder( pRecorder.get() );
+	}
+
 	WNDCLASSEX wc = { sizeof( WNDCLASSEX ),CS_CLASSDC,MsgProc,0,0,
                       GetModuleHandle( NULL ),NULL,NULL,NULL,NULL,
                       L"Chili DirectX Framework Window",NULL };
@@ -156,7 +228,34 @@ int WINAPI wWinMain( HINSTANCE hInst,HINSTANCE,LPWSTR,INT )
     ShowWindow( hWnd,SW_SHOWDEFAULT );
     UpdateWindow( hWnd );
 
-	Game theGame( hWnd,kServ,mServ );
+	// "-export <name>" publishes every presented frame in the shared mapping <name>
+	// (FrameExportReader on the other side); declared first so it outlives the game
+	std::unique_ptr<FrameExport> pExport;
+	const std::wstring exportName = GetSwitchArg( pCmdLine,L"-export" );
+	if( !exportName.empty() )
+	{
+		pExport.reset( new FrameExport( exportName,D3DGraphics::screenWidth,D3DGraphics::screenHeight ) );
+	}
+
+	// "-pipelined" overlaps UpdateModel with ComposeFrame / Present on a render thread
+	const bool pipelined = wcsstr( pCmdLine,L"-pipelined" ) != nullptr;
+	Game theGame( hWnd,kServ,mServ,pipelined );
+	if( pExport && pExport->IsValid() )
+	{
+		theGame.SetFrameExport( pExport.get() );
+	}
+
+	// "-mirror <file>" streams every frame as changed-tile packets (FrameDelta) for a
+	// spectator to decode; not with -pipelined, where the frame is owned by the render thread
+	std::unique_ptr<FrameDelta::Encoder> pMirror;
+	std::ofstream mirrorFile;
+	std::vector<unsigned char> mirrorPacket;
+	const std::wstring mirrorPath = GetSwitchArg( pCmdLine,L"-mirror" );
+	if( !mirrorPath.empty() && !pipelined )
+	{
+		mirrorFile.open( mirrorPath.c_str(),std::ios::binary );
+		pMirror.reset( new FrameDelta::Encoder( D3DGraphics::screenWidth,D3DGraphics::screenHeight ) );
+	}
 	
     MSG msg;
     ZeroMemory( &msg,sizeof( msg ) );
@@ -174,6 +273,16 @@ int WINAPI wWinMain( HINSTANCE hInst,HINSTANCE,LPWSTR,INT )
 			DispatchMessage( &msg );
 		}
 
+		if( pRecorder )
+		{
+			pRecorder->OnFrame();
+		}
 		theGame.Go();
+		if( pMirror )
+		{
+			mirrorPacket.clear();
+			pMirror->Encode( theGame.GetFrame(),mirrorPacket );
+			mirrorFile.write( reinterpret_cast<const char*>( mirrorPacket.data() ),mirrorPacket.size() );
+		}
 	}
 }
\ No newline at end of file
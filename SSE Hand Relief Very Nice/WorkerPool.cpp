@@ -0,0 +1,111 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	WorkerPool.cpp																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool( unsigned int nWorkers )
+	:
+	pJob( nullptr ),
+	nJobs( 0 ),
+	generation( 0 ),
+	nActive( 0 ),
+	stopping( false ),
+	nextJob( 0 ),
+	nFinished( 0 )
+{
+	for( unsigned int i = 0; i < nWorkers; i++ )
+	{
+		workers.push_back( std::thread( &WorkerPool::WorkerLoop,this ) );
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		stopping = true;
+	}
+	wake.notify_all();
+	for( std::thread& t : workers )
+	{
+		t.join();
+	}
+}
+
+unsigned int WorkerPool::GetThreadCount() const
+{
+	return (unsigned int)workers.size() + 1;
+}
+
+void WorkerPool::Run( unsigned int n,const std::function<void( unsigned int )>& job )
+{
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+		// a worker that woke late for the previous Run may still be draining it
+		idle.wait( lock,[this](){ return nActive == 0; } );
+		pJob = &job;
+		nJobs = n;
+		nextJob = 0;
+		nFinished = 0;
+		generation++;
+	}
+	wake.notify_all();
+	Drain( &job,n );
+
+	std::unique_lock<std::mutex> lock( mutex );
+	idle.wait( lock,[this,n](){ return nFinished == n; } );
+}
+
+void WorkerPool::WorkerLoop()
+{
+	unsigned long long seenGeneration = 0;
+	std::unique_lock<std::mutex> lock( mutex );
+	while( true )
+	{
+		wake.wait( lock,[this,seenGeneration](){ return stopping || generation != seenGeneration; } );
+		if( stopping )
+		{
+			return;
+		}
+		seenGeneration = generation;
+		const std::function<void( unsigned int )>* const pCurJob = pJob;
+		const unsigned int nCurJobs = nJobs;
+		nActive++;
+		lock.unlock();
+		Drain( pCurJob,nCurJobs );
+		lock.lock();
+		nActive--;
+		idle.notify_all();
+	}
+}
+
+void WorkerPool::Drain( const std::function<void( unsigned int )>* pCurJob,unsigned int nCurJobs )
+{
+	for( unsigned int i = nextJob++; i < nCurJobs; i = nextJob++ )
+	{
+		( *pCurJob )( i );
+		if( ++nFinished == nCurJobs )
+		{
+			// take the lock so the notify can't slip in between Run's check and its wait
+			std::lock_guard<std::mutex> lock( mutex );
+			idle.notify_all();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	WorkerPool.h																		  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// fixed set of threads for fork-join work like banded image passes
+// Run hands out job indices to the workers and the calling thread alike and returns
+// once every job has finished, so Run with nWorkers = 0 is a plain loop
+class WorkerPool
+{
+public:
+	WorkerPool( unsigned int nWorkers );
+	WorkerPool( const WorkerPool& ) = delete;
+	WorkerPool& operator=( const WorkerPool& ) = delete;
+	~WorkerPool();
+	// workers plus the calling thread
+	unsigned int GetThreadCount() const;
+	// calls job( 0 ) .. job( nJobs - 1 ) in parallel, blocks until all are done
+	void Run( unsigned int nJobs,const std::function<void( unsigned int )>& job );
+private:
+	void WorkerLoop();
+	void Drain( const std::function<void( unsigned int )>* pJob,unsigned int nJobs );
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable idle;
+	// current job set, only written while no worker is active
+	const std::function<void( unsigned int )>* pJob;
+	unsigned int nJobs;
+	unsigned long long generation;
+	unsigned int nActive;
+	bool stopping;
+	std::atomic<unsigned int> nextJob;
+	std::atomic<unsigned int> nFinished;
+};
\ No newline at end of file
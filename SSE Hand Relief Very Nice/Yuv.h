@@ -0,0 +1,251 @@
+/******************************************************************************************
+*	Chili DirectX Framework Version 14.03.22											  *
+*	Yuv.h																				  *
+*	Copyright 2014 PlanetChili.net <http://www.planetchili.net>							  *
+*																						  *
+*	This file is part of The Chili DirectX Framework.									  *
+*																						  *
+*	The Chili DirectX Framework is free software: you can redistribute it and/or modify	  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The Chili DirectX Framework is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
+******************************************************************************************/
+#pragma once
+
+#include "Vec2.h"
+#include "Rect.h"
+#include "Surface.h"
+#include "PixelPipeline.h"
+#include <string.h>
+#include <immintrin.h>
+
+// Color -> 4:2:0 YUV for video output, studio range (Y 16..235, U / V 16..240)
+// each pass takes two source rows and writes both luma rows plus one chroma row, the
+// chroma being the transform of the 2x2 average (centred siting, Y4M's 420jpeg)
+// RowPair< Isa > follows PixelFormat's Unpack / Pack: the SSE2 kernel matches the scalar
+// one bit for bit and finishes its row pairs with it
+namespace Yuv
+{
+	enum Matrix
+	{
+		BT601,
+		BT709
+	};
+
+	// 8-bit fixed point weights in b,g,r order
+	struct Coefficients
+	{
+		short y[3];
+		short u[3];
+		short v[3];
+	};
+
+	inline const Coefficients& GetCoefficients( Matrix matrix )
+	{
+		static const Coefficients table[2] =
+		{
+			{ { 25,129,66 },{ 112,-74,-38 },{ -18,-94,112 } },
+			{ { 16,157,47 },{ 112,-87,-26 },{ -10,-102,112 } }
+		};
+		return table[matrix];
+	}
+
+	// I420 has separate U and V planes (uvStep 1), NV12 one interleaved UV plane whose
+	// V bytes start at u + 1 (uvStep 2); chroma is ( width + 1 ) / 2 x ( height + 1 ) / 2
+	struct Planes
+	{
+		unsigned char* y;
+		unsigned int yPitch;
+		unsigned char* u;
+		unsigned char* v;
+		unsigned int uvPitch;
+		unsigned int uvStep;
+	};
+
+	inline Planes I420( unsigned char* y,unsigned int yPitch,unsigned char* u,unsigned char* v,unsigned int uvPitch )
+	{
+		const Planes planes = { y,yPitch,u,v,uvPitch,1 };
+		return planes;
+	}
+
+	inline Planes NV12( unsigned char* y,unsigned int yPitch,unsigned char* uv,unsigned int uvPitch )
+	{
+		const Planes planes = { y,yPitch,uv,uv + 1,uvPitch,2 };
+		return planes;
+	}
+
+	namespace Detail
+	{
+		inline unsigned char Luma( Color c,const Coefficients& k )
+		{
+			return (unsigned char)( 16 + ( ( k.y[0] * c.b + k.y[1] * c.g + k.y[2] * c.r + 128 ) >> 8 ) );
+		}
+
+		// from channel sums of four pixels
+		inline unsigned char Chroma( const short* weights,int b,int g,int r )
+		{
+			return (unsigned char)( 128 + ( ( weights[0] * b + weights[1] * g + weights[2] * r + 512 ) >> 10 ) );
+		}
+
+		// sums of the 32-bit pairs pmaddwd leaves for each pixel: [ a0 + a1,a2 + a3,b0 + b1,b2 + b3 ]
+		inline __m128i AddPairs( __m128i a,__m128i b )
+		{
+			const __m128 af = _mm_castsi128_ps( a );
+			const __m128 bf = _mm_castsi128_ps( b );
+			return _mm_add_epi32(
+				_mm_castps_si128( _mm_shuffle_ps( af,bf,_MM_SHUFFLE( 2,0,2,0 ) ) ),
+				_mm_castps_si128( _mm_shuffle_ps( af,bf,_MM_SHUFFLE( 3,1,3,1 ) ) ) );
+		}
+
+		inline __m128i Luma4( __m128i p,__m128i weights )
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i sums = AddPairs(
+				_mm_madd_epi16( _mm_unpacklo_epi8( p,zero ),weights ),
+				_mm_madd_epi16( _mm_unpackhi_epi8( p,zero ),weights ) );
+			return _mm_add_epi32( _mm_srai_epi32( _mm_add_epi32( sums,_mm_set1_epi32( 128 ) ),8 ),_mm_set1_epi32( 16 ) );
+		}
+
+		inline __m128i Luma8( const Color* p,__m128i weights )
+		{
+			const __m128i y16 = _mm_packs_epi32(
+				Luma4( _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) ),weights ),
+				Luma4( _mm_loadu_si128( reinterpret_cast<const __m128i*>( p + 4 ) ),weights ) );
+			return _mm_packus_epi16( y16,y16 );
+		}
+
+		inline __m128i Weights( const short* k )
+		{
+			return _mm_setr_epi16( k[0],k[1],k[2],0,k[0],k[1],k[2],0 );
+		}
+	}
+
+	template< class Isa >
+	struct RowPair;
+
+	// pRow1 is pRow0 again and pY1 nullptr for the last row of an odd height
+	template<>
+	struct RowPair< Pixel::Scalar >
+	{
+		static void Run( const Color* pRow0,const Color* pRow1,unsigned int width,
+			unsigned char* pY0,unsigned char* pY1,unsigned char* pU,unsigned char* pV,
+			unsigned int uvStep,const Coefficients& k,unsigned int xStart = 0 )
+		{
+			for( unsigned int x = xStart; x < width; x += 2 )
+			{
+				// an odd last column is averaged with itself
+				const unsigned int xNext = x + 1 < width ? x + 1 : x;
+				const Color p00 = pRow0[x];
+				const Color p01 = pRow0[xNext];
+				const Color p10 = pRow1[x];
+				const Color p11 = pRow1[xNext];
+				pY0[x] = Detail::Luma( p00,k );
+				if( xNext != x )
+				{
+					pY0[xNext] = Detail::Luma( p01,k );
+				}
+				if( pY1 )
+				{
+					pY1[x] = Detail::Luma( p10,k );
+					if( xNext != x )
+					{
+						pY1[xNext] = Detail::Luma( p11,k );
+					}
+				}
+				const int b = p00.b + p01.b + p10.b + p11.b;
+				const int g = p00.g + p01.g + p10.g + p11.g;
+				const int r = p00.r + p01.r + p10.r + p11.r;
+				pU[x / 2 * uvStep] = Detail::Chroma( k.u,b,g,r );
+				pV[x / 2 * uvStep] = Detail::Chroma( k.v,b,g,r );
+			}
+		}
+	};
+
+	// 8 columns at a time: 16 luma samples and 4 U / V from pmaddwd on 16-bit channels
+	template<>
+	struct RowPair< Pixel::SSE2 >
+	{
+		static void Run( const Color* pRow0,const Color* pRow1,unsigned int width,
+			unsigned char* pY0,unsigned char* pY1,unsigned char* pU,unsigned char* pV,
+			unsigned int uvStep,const Coefficients& k )
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i yWeights = Detail::Weights( k.y );
+			const __m128i uWeights = Detail::Weights( k.u );
+			const __m128i vWeights = Detail::Weights( k.v );
+			const __m128i chromaRound = _mm_set1_epi32( 512 );
+			const __m128i chromaOffset = _mm_set1_epi32( 128 );
+			unsigned int x = 0;
+			for( ; x + 8 <= width; x += 8 )
+			{
+				_mm_storel_epi64( reinterpret_cast<__m128i*>( pY0 + x ),Detail::Luma8( pRow0 + x,yWeights ) );
+				if( pY1 )
+				{
+					_mm_storel_epi64( reinterpret_cast<__m128i*>( pY1 + x ),Detail::Luma8( pRow1 + x,yWeights ) );
+				}
+				// vertical pair sums, 16 bits per channel, two pixels per register
+				const __m128i a0 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow0 + x ) );
+				const __m128i a1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow0 + x + 4 ) );
+				const __m128i b0 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow1 + x ) );
+				const __m128i b1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow1 + x + 4 ) );
+				const __m128i s01 = _mm_add_epi16( _mm_unpacklo_epi8( a0,zero ),_mm_unpacklo_epi8( b0,zero ) );
+				const __m128i s23 = _mm_add_epi16( _mm_unpackhi_epi8( a0,zero ),_mm_unpackhi_epi8( b0,zero ) );
+				const __m128i s45 = _mm_add_epi16( _mm_unpacklo_epi8( a1,zero ),_mm_unpacklo_epi8( b1,zero ) );
+				const __m128i s67 = _mm_add_epi16( _mm_unpackhi_epi8( a1,zero ),_mm_unpackhi_epi8( b1,zero ) );
+				// then horizontal: [ c0,c1 ] and [ c2,c3 ], the four 2x2 blocks
+				const __m128i c01 = _mm_add_epi16( _mm_unpacklo_epi64( s01,s23 ),_mm_unpackhi_epi64( s01,s23 ) );
+				const __m128i c23 = _mm_add_epi16( _mm_unpacklo_epi64( s45,s67 ),_mm_unpackhi_epi64( s45,s67 ) );
+				const __m128i u = Detail::AddPairs( _mm_madd_epi16( c01,uWeights ),_mm_madd_epi16( c23,uWeights ) );
+				const __m128i v = Detail::AddPairs( _mm_madd_epi16( c01,vWeights ),_mm_madd_epi16( c23,vWeights ) );
+				const __m128i u32 = _mm_add_epi32( _mm_srai_epi32( _mm_add_epi32( u,chromaRound ),10 ),chromaOffset );
+				const __m128i v32 = _mm_add_epi32( _mm_srai_epi32( _mm_add_epi32( v,chromaRound ),10 ),chromaOffset );
+				const __m128i uv16 = _mm_packs_epi32( u32,v32 );
+				// U0..U3 V0..V3
+				const __m128i uv8 = _mm_packus_epi16( uv16,uv16 );
+				if( uvStep == 2 )
+				{
+					_mm_storel_epi64( reinterpret_cast<__m128i*>( pU + x ),
+						_mm_unpacklo_epi8( uv8,_mm_srli_si128( uv8,4 ) ) );
+				}
+				else
+				{
+					const int uBytes = _mm_cvtsi128_si32( uv8 );
+					const int vBytes = _mm_cvtsi128_si32( _mm_srli_si128( uv8,4 ) );
+					memcpy( pU + x / 2,&uBytes,4 );
+					memcpy( pV + x / 2,&vBytes,4 );
+				}
+			}
+			RowPair< Pixel::Scalar >::Run( pRow0,pRow1,width,pY0,pY1,pU,pV,uvStep,k,x );
+		}
+	};
+
+	template< class Isa >
+	void Convert( const Color* pPixels,unsigned int width,unsigned int height,unsigned int pixelPitch,
+		const Planes& dst,Matrix matrix = BT601 )
+	{
+		const Coefficients& k = GetCoefficients( matrix );
+		for( unsigned int y = 0; y < height; y += 2 )
+		{
+			const bool pair = y + 1 < height;
+			const Color* const pRow0 = &pPixels[y * pixelPitch];
+			RowPair< Isa >::Run( pRow0,pair ? pRow0 + pixelPitch : pRow0,width,
+				dst.y + y * dst.yPitch,pair ? dst.y + ( y + 1 ) * dst.yPitch : nullptr,
+				dst.u + ( y / 2 ) * dst.uvPitch,dst.v + ( y / 2 ) * dst.uvPitch,dst.uvStep,k );
+		}
+	}
+
+	template< class Isa >
+	void Convert( const Surface& src,const Planes& dst,Matrix matrix = BT601 )
+	{
+		PROFILE_FUNCTION();
+		Convert< Isa >( src.GetBufferConst(),src.GetWidth(),src.GetHeight(),src.GetPixelPitch(),dst,matrix );
+	}
+}
\ No newline at end of file